@@ -0,0 +1,595 @@
+/**
+ * @file bench.c
+ * @brief Banc d'essai non interactif du système de fichiers (cible make bench).
+ *
+ * Chaque charge de travail est déterministe (graine fixe) et s'exécute sur
+ * une partition fraîchement formatée dans un répertoire temporaire. Les
+ * résultats (débit et latences p50/p99/p999) sont écrits en JSON sur la
+ * sortie standard, ou dans le fichier passé en argument ; les messages de
+ * la bibliothèque sont envoyés vers /dev/null pour ne pas s'y mêler.
+ */
+
+#include "test.h"
+#include "blockops.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+
+#define BENCH_SEED 42 /**< Graine des charges aléatoires */
+#define BENCH_FILE_SIZE (256 * 1024) /**< Taille des fichiers des tests d'entrées/sorties */
+#define BENCH_PASSES 3 /**< Passages par charge d'entrées/sorties */
+#define BENCH_CHURN_OPS 20000 /**< Opérations du test d'allocation */
+#define BENCH_SMALL_FILES 500 /**< Fichiers du corpus de petits fichiers */
+#define BENCH_COPIES 8 /**< Copies du test de déduplication */
+#define BENCH_COPY_STRIDE 4 /**< Une copie modifie un bloc sur BENCH_COPY_STRIDE */
+#define BENCH_KERNEL_BLOCKS 8 /**< Blocs par appel de noyau (un morceau compressé) */
+#define BENCH_KERNEL_TOTAL (256 * 1024 * 1024) /**< Octets traités par noyau de copie ou de remise à zéro */
+#define BENCH_KERNEL_SAMPLES 256 /**< Mesures de latence par noyau de copie ou de remise à zéro */
+#define BENCH_SCAN_CALLS 20000 /**< Parcours complets de la table d'occupation */
+
+static FILE* g_json; /**< Flux de sortie des résultats */
+static int g_firstResult = 1; /**< Pas de virgule avant le premier résultat */
+static long long* g_samples; /**< Latences de la charge en cours (ns) */
+static int g_sampleCount; /**< Nombre de latences enregistrées */
+static int g_sampleCapacity; /**< Capacité du tableau des latences */
+
+/**
+ * @brief Horloge monotone en nanosecondes.
+ */
+static long long nowNs(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000000000LL + ts.tv_nsec;
+}
+
+/**
+ * @brief Enregistre la latence d'une opération.
+ */
+static void addSample(long long ns) {
+    if (g_sampleCount == g_sampleCapacity) {
+        g_sampleCapacity = g_sampleCapacity ? 2 * g_sampleCapacity : 4096;
+        g_samples = (long long*)realloc(g_samples, g_sampleCapacity * sizeof(long long));
+        if (!g_samples) {
+            perror("Échec de l'allocation des mesures");
+            exit(1);
+        }
+    }
+    g_samples[g_sampleCount++] = ns;
+}
+
+/**
+ * @brief Comparaison pour qsort.
+ */
+static int compareSamples(const void* a, const void* b) {
+    long long x = *(const long long*)a;
+    long long y = *(const long long*)b;
+    return (x > y) - (x < y);
+}
+
+/**
+ * @brief Centile des latences enregistrées (tableau déjà trié).
+ */
+static long long percentile(double p) {
+    if (g_sampleCount == 0) {
+        return 0;
+    }
+    int index = (int)(p * (g_sampleCount - 1) + 0.5);
+    return g_samples[index];
+}
+
+/**
+ * @brief Écrit un résultat à partir des latences enregistrées puis les oublie.
+ *
+ * @param name Nom de la charge.
+ * @param chunk Taille des opérations en octets (0 si sans objet).
+ * @param bytes Octets traités pendant la charge.
+ * @param elapsedNs Durée totale de la charge.
+ * @param extra Champs JSON supplémentaires (commençant par une virgule) ou "".
+ */
+static void report(const char* name, int chunk, long long bytes, long long elapsedNs, const char* extra) {
+    qsort(g_samples, g_sampleCount, sizeof(long long), compareSamples);
+    double seconds = elapsedNs / 1e9;
+    fprintf(g_json, "%s\n    {\"name\": \"%s\", \"chunk\": %d, \"ops\": %d, \"bytes\": %lld, "
+            "\"ops_per_s\": %.1f, \"mb_per_s\": %.3f, \"p50_ns\": %lld, \"p99_ns\": %lld, \"p999_ns\": %lld%s}",
+            g_firstResult ? "" : ",", name, chunk, g_sampleCount, bytes,
+            seconds > 0 ? g_sampleCount / seconds : 0.0,
+            seconds > 0 ? bytes / seconds / (1024.0 * 1024.0) : 0.0,
+            percentile(0.50), percentile(0.99), percentile(0.999), extra);
+    g_firstResult = 0;
+    g_sampleCount = 0;
+}
+
+/**
+ * @brief Crée un fichier vide sur l'hôte puis l'ouvre sans question.
+ */
+static file* createFile(const char* name) {
+    FILE* fp = fopen(name, "wb");
+    if (!fp) {
+        perror("Échec de la création d'un fichier de test");
+        exit(1);
+    }
+    fclose(fp);
+    return myOpen((char*)name);
+}
+
+/**
+ * @brief Taille d'un fichier sur l'hôte.
+ */
+static long hostSize(const char* name) {
+    struct stat st;
+    return stat(name, &st) == 0 ? (long)st.st_size : -1;
+}
+
+/**
+ * @brief Remplit un tampon de lignes de journal (données compressibles).
+ */
+static void fillLog(char* buffer, int size) {
+    int len = 0;
+    for (int i = 0; len < size; ++i) {
+        char line[128];
+        int n = snprintf(line, sizeof(line), "2026-10-19T12:%02d:%02d INFO worker=%d request=%d status=ok\n",
+                         (i / 60) % 60, i % 60, rand() % 8, rand() % 100000);
+        if (n > size - len) n = size - len;
+        memcpy(buffer + len, line, n);
+        len += n;
+    }
+}
+
+/**
+ * @brief Écrit un fichier séquentiellement par morceaux de chunk octets.
+ */
+static void writeSequential(file* f, const char* data, int size, int chunk) {
+    mySeek(f, 0, SEEK_SET);
+    for (int off = 0; off < size; off += chunk) {
+        int n = size - off < chunk ? size - off : chunk;
+        long long t = nowNs();
+        myWrite(f, (void*)(data + off), n);
+        addSample(nowNs() - t);
+    }
+}
+
+/**
+ * @brief Lecture et écriture séquentielles et aléatoires pour plusieurs tailles.
+ */
+static void benchIo(const char* prefix, const char* data) {
+    static const int chunks[] = {64, 512, 4096};
+    char* buffer = (char*)malloc(4096);
+
+    for (size_t c = 0; c < sizeof(chunks) / sizeof(chunks[0]); ++c) {
+        int chunk = chunks[c];
+        char name[64];
+        int ops = BENCH_FILE_SIZE / chunk;
+
+        // Écriture séquentielle dans un fichier neuf ; le dernier sert aux tests suivants
+        file* f = NULL;
+        long long total = 0;
+        for (int pass = 0; pass < BENCH_PASSES; ++pass) {
+            if (f) {
+                myClose(f);
+            }
+            myFormat("bench.img");
+            f = createFile("io.dat");
+            long long t = nowNs();
+            writeSequential(f, data, BENCH_FILE_SIZE, chunk);
+            total += nowNs() - t;
+        }
+        snprintf(name, sizeof(name), "%sseq_write", prefix);
+        report(name, chunk, (long long)BENCH_PASSES * BENCH_FILE_SIZE, total, "");
+
+        total = 0;
+        for (int pass = 0; pass < BENCH_PASSES; ++pass) {
+            mySeek(f, 0, SEEK_SET);
+            long long t = nowNs();
+            for (int i = 0; i < ops; ++i) {
+                long long s = nowNs();
+                myRead(f, buffer, chunk);
+                addSample(nowNs() - s);
+            }
+            total += nowNs() - t;
+        }
+        snprintf(name, sizeof(name), "%sseq_read", prefix);
+        report(name, chunk, (long long)BENCH_PASSES * BENCH_FILE_SIZE, total, "");
+
+        srand(BENCH_SEED);
+        total = 0;
+        for (int pass = 0; pass < BENCH_PASSES; ++pass) {
+            long long t = nowNs();
+            for (int i = 0; i < ops; ++i) {
+                mySeek(f, (rand() % ops) * chunk, SEEK_SET);
+                long long s = nowNs();
+                myWrite(f, (void*)(data + (i * chunk) % BENCH_FILE_SIZE), chunk);
+                addSample(nowNs() - s);
+            }
+            total += nowNs() - t;
+        }
+        snprintf(name, sizeof(name), "%srand_write", prefix);
+        report(name, chunk, (long long)BENCH_PASSES * BENCH_FILE_SIZE, total, "");
+
+        srand(BENCH_SEED);
+        total = 0;
+        for (int pass = 0; pass < BENCH_PASSES; ++pass) {
+            long long t = nowNs();
+            for (int i = 0; i < ops; ++i) {
+                mySeek(f, (rand() % ops) * chunk, SEEK_SET);
+                long long s = nowNs();
+                myRead(f, buffer, chunk);
+                addSample(nowNs() - s);
+            }
+            total += nowNs() - t;
+        }
+        snprintf(name, sizeof(name), "%srand_read", prefix);
+        report(name, chunk, (long long)BENCH_PASSES * BENCH_FILE_SIZE, total, "");
+
+        if (c == sizeof(chunks) / sizeof(chunks[0]) - 1) {
+            char extra[96];
+            snprintf(extra, sizeof(extra), ", \"logical_bytes\": %d, \"physical_bytes\": %ld",
+                     f->size, hostSize("io.dat"));
+            snprintf(name, sizeof(name), "%sfile_size", prefix);
+            report(name, 0, 0, 0, extra);
+        }
+        myDelete(f);
+    }
+    free(buffer);
+}
+
+/**
+ * @brief Allocations et libérations aléatoires sur une partition morcelée.
+ */
+static void benchAllocatorChurn(void) {
+    enum { SLOTS = 256 };
+    file* slots = (file*)calloc(SLOTS, sizeof(file));
+    char* live = (char*)calloc(SLOTS, 1);
+    long long failures = 0;
+
+    myFormat("bench.img");
+    srand(BENCH_SEED);
+
+    // Morceler la partition : remplir puis libérer un fichier sur deux
+    for (int i = 0; i < SLOTS; ++i) {
+        live[i] = allocateBlocks(&slots[i], 2 * BLOCK_SIZE + rand() % (6 * BLOCK_SIZE)) != -1;
+    }
+    for (int i = 0; i < SLOTS; i += 2) {
+        if (live[i]) {
+            freeBlocks(&slots[i]);
+            live[i] = 0;
+        }
+    }
+
+    long long t = nowNs();
+    for (int i = 0; i < BENCH_CHURN_OPS; ++i) {
+        int k = rand() % SLOTS;
+        long long s = nowNs();
+        if (live[k]) {
+            freeBlocks(&slots[k]);
+            live[k] = 0;
+        } else {
+            live[k] = allocateBlocks(&slots[k], BLOCK_SIZE + rand() % (12 * BLOCK_SIZE)) != -1;
+            failures += !live[k];
+        }
+        addSample(nowNs() - s);
+    }
+    long long total = nowNs() - t;
+
+    SpaceReport space;
+    getSpaceReport(&space);
+    char extra[160];
+    snprintf(extra, sizeof(extra), ", \"alloc_failures\": %lld, \"free_blocks\": %d, \"largest_free_run\": %d, \"fragmentation\": %.3f",
+             failures, space.free_blocks, space.largest_free_run, space.fragmentation);
+    report("alloc_free_churn", 0, 0, total, extra);
+
+    t = nowNs();
+    for (int i = 0; i < BENCH_CHURN_OPS; ++i) {
+        long long s = nowNs();
+        findFreeBlocks(1 + i % 16);
+        addSample(nowNs() - s);
+    }
+    report("find_free_blocks", 0, 0, nowNs() - t, "");
+
+    for (int i = 0; i < SLOTS; ++i) {
+        if (live[i]) {
+            freeBlocks(&slots[i]);
+        }
+    }
+    free(slots);
+    free(live);
+}
+
+/**
+ * @brief Corpus de petits fichiers : création, ouverture, lecture, suppression et place occupée.
+ */
+static void benchSmallFiles(const char* data) {
+    int sizes[BENCH_SMALL_FILES];
+    file* files[BENCH_SMALL_FILES];
+    char name[32];
+    long long bytes = 0;
+    long long naiveBlocks = 0;
+
+    myFormat("bench.img");
+    srand(BENCH_SEED);
+    for (int i = 0; i < BENCH_SMALL_FILES; ++i) {
+        int kind = rand() % 10;
+        sizes[i] = kind < 4 ? 1 + rand() % INLINE_DATA_SIZE                   // configuration minuscule
+                 : kind < 8 ? INLINE_DATA_SIZE + 1 + rand() % BLOCK_SIZE      // petit état
+                 : BLOCK_SIZE + rand() % (7 * BLOCK_SIZE);                     // petit document
+        bytes += sizes[i];
+        naiveBlocks += (sizes[i] + BLOCK_SIZE - 1) / BLOCK_SIZE;
+    }
+
+    long long t = nowNs();
+    for (int i = 0; i < BENCH_SMALL_FILES; ++i) {
+        snprintf(name, sizeof(name), "small%d", i);
+        long long s = nowNs();
+        files[i] = createFile(name);
+        myWrite(files[i], (void*)data, sizes[i]);
+        addSample(nowNs() - s);
+    }
+    report("small_file_create", 0, bytes, nowNs() - t, "");
+
+    SpaceReport space;
+    getSpaceReport(&space);
+    long long usedBlocks = TOTAL_BLOCKS - space.free_blocks;
+    int inlineFiles = 0;
+    for (int i = 0; i < BENCH_SMALL_FILES; ++i) {
+        inlineFiles += files[i]->inline_data;
+    }
+
+    char* buffer = (char*)malloc(8 * BLOCK_SIZE);
+    t = nowNs();
+    for (int i = 0; i < BENCH_SMALL_FILES; ++i) {
+        mySeek(files[i], 0, SEEK_SET);
+        long long s = nowNs();
+        myRead(files[i], buffer, sizes[i]);
+        addSample(nowNs() - s);
+    }
+    report("small_file_read", 0, bytes, nowNs() - t, "");
+    free(buffer);
+
+    t = nowNs();
+    for (int i = 0; i < BENCH_SMALL_FILES; ++i) {
+        snprintf(name, sizeof(name), "small%d", i);
+        myClose(files[i]);
+        long long s = nowNs();
+        file* f = myOpen(name);
+        addSample(nowNs() - s);
+        files[i] = f;
+    }
+    report("open", 0, 0, nowNs() - t, "");
+
+    t = nowNs();
+    for (int i = 0; i < BENCH_SMALL_FILES; ++i) {
+        long long s = nowNs();
+        myDelete(files[i]);
+        addSample(nowNs() - s);
+    }
+
+    char extra[256];
+    snprintf(extra, sizeof(extra), ", \"files\": %d, \"inline_files\": %d, \"blocks_used\": %lld, "
+             "\"blocks_one_per_block\": %lld, \"capacity_use\": %.3f",
+             BENCH_SMALL_FILES, inlineFiles, usedBlocks, naiveBlocks,
+             usedBlocks > 0 ? (double)bytes / (usedBlocks * BLOCK_SIZE) : 0.0);
+    report("small_file_delete", 0, bytes, nowNs() - t, extra);
+}
+
+/**
+ * @brief Copie d'un gros fichier avec myCopy.
+ */
+static void benchLargeCopy(const char* data) {
+    myFormat("bench.img");
+    file* f = createFile("large.dat");
+    writeSequential(f, data, BENCH_FILE_SIZE, 4096);
+    g_sampleCount = 0;
+    myClose(f);
+
+    long long t = nowNs();
+    for (int pass = 0; pass < 4 * BENCH_PASSES; ++pass) {
+        long long s = nowNs();
+        myCopy("large.dat", "large_copy.dat");
+        addSample(nowNs() - s);
+    }
+    report("large_copy", BENCH_FILE_SIZE, 4LL * BENCH_PASSES * BENCH_FILE_SIZE, nowNs() - t, "");
+    remove("large.dat");
+    remove("large_copy.dat");
+}
+
+/**
+ * @brief Écriture de copies presque identiques avec et sans déduplication.
+ *
+ * Chaque copie modifie un octet dans un bloc sur BENCH_COPY_STRIDE, à des
+ * blocs différents d'une copie à l'autre : seuls les autres blocs peuvent
+ * être partagés. Mesure l'espace économisé (blocks_used) et le coût de
+ * l'empreinte et des comparaisons : les octets sont écrits dans les
+ * fichiers hôtes dans les deux cas.
+ */
+static void benchDedup(const char* data) {
+    int size = 64 * 1024;
+    char* copies = (char*)malloc((size_t)BENCH_COPIES * size);
+    if (!copies) {
+        perror("Échec de l'allocation des copies");
+        return;
+    }
+    for (int i = 0; i < BENCH_COPIES; ++i) {
+        char* copy = copies + (size_t)i * size;
+        memcpy(copy, data, size);
+        for (int b = i % BENCH_COPY_STRIDE; b * BLOCK_SIZE < size; b += BENCH_COPY_STRIDE) {
+            copy[b * BLOCK_SIZE + i] ^= 0x5a;  // Position propre à la copie : jamais partagée
+        }
+    }
+
+    for (int enabled = 0; enabled <= 1; ++enabled) {
+        myFormat("bench.img");
+        setDeduplication(enabled);
+        file* files[BENCH_COPIES];
+
+        long long t = nowNs();
+        for (int i = 0; i < BENCH_COPIES; ++i) {
+            char name[32];
+            snprintf(name, sizeof(name), "copy%d", i);
+            files[i] = createFile(name);
+            writeSequential(files[i], copies + (size_t)i * size, size, 4096);
+        }
+        long long total = nowNs() - t;
+
+        SpaceReport space;
+        getSpaceReport(&space);
+        char extra[128];
+        snprintf(extra, sizeof(extra), ", \"dedup_ratio\": %.3f, \"blocks_used\": %d",
+                 getDedupRatio(), TOTAL_BLOCKS - space.free_blocks);
+        report(enabled ? "dedup_on_write" : "dedup_off_write", 4096, (long long)BENCH_COPIES * size, total, extra);
+
+        for (int i = 0; i < BENCH_COPIES; ++i) {
+            myDelete(files[i]);
+        }
+        setDeduplication(0);
+    }
+    free(copies);
+}
+
+/**
+ * @brief Noyaux spécialisés par taille de bloc contre les noyaux génériques.
+ *
+ * Chaque copie ou remise à zéro porte sur BENCH_KERNEL_BLOCKS blocs,
+ * comme celles des morceaux compressés ; BENCH_KERNEL_TOTAL octets sont
+ * répartis en BENCH_KERNEL_SAMPLES mesures de latence, quelle que soit la
+ * taille de bloc. Les noyaux génériques ne sont mesurés que pour les tailles
+ * où la copie et la remise à zéro sont réellement spécialisées (pour 4096 et
+ * 65536 octets, ce sont les mêmes memcpy et memset). Les recherches parcourent une table
+ * d'occupation pleine aux trois quarts (zones de 48 blocs utilisés
+ * séparées par 16 blocs libres), comme findFreeBlocks et markBlocks.
+ */
+static void benchKernels(void) {
+    static const int sizes[] = {512, 4096, 65536};
+    int maxBytes = BENCH_KERNEL_BLOCKS * sizes[2];
+    char* src = (char*)aligned_alloc(64, maxBytes);
+    char* dst = (char*)aligned_alloc(64, maxBytes);
+    memset(src, 0x5a, maxBytes);
+    memset(dst, 0, maxBytes);
+
+    for (int s = 0; s < 3; ++s) {
+        int bytes = BENCH_KERNEL_BLOCKS * sizes[s];
+        int batch = BENCH_KERNEL_TOTAL / bytes / BENCH_KERNEL_SAMPLES;  // Appels par mesure
+        const BlockKernels* variants[] = {selectBlockKernels(sizes[s]), genericBlockKernels()};
+        for (int v = 0; v < 2; ++v) {
+            const BlockKernels* k = variants[v];
+            if (v == 1 && k->copy_blocks == variants[0]->copy_blocks && k->zero_blocks == variants[0]->zero_blocks) {
+                continue;  // Mêmes noyaux : la ligne générique serait un doublon
+            }
+            char name[64];
+            char extra[96];
+            snprintf(extra, sizeof(extra), ", \"block_size\": %d, \"kernels\": \"%s\"", sizes[s], k->name);
+
+            long long t = nowNs();
+            for (int i = 0; i < BENCH_KERNEL_SAMPLES; ++i) {
+                long long start = nowNs();
+                for (int j = 0; j < batch; ++j) {
+                    k->copy_blocks(dst, src, bytes);
+                }
+                addSample(nowNs() - start);
+            }
+            snprintf(name, sizeof(name), "kernel_copy_%d_%s", sizes[s], v == 0 ? "specialized" : "generic");
+            report(name, bytes, (long long)BENCH_KERNEL_SAMPLES * batch * bytes, nowNs() - t, extra);
+
+            t = nowNs();
+            for (int i = 0; i < BENCH_KERNEL_SAMPLES; ++i) {
+                long long start = nowNs();
+                for (int j = 0; j < batch; ++j) {
+                    k->zero_blocks(dst, bytes);
+                }
+                addSample(nowNs() - start);
+            }
+            snprintf(name, sizeof(name), "kernel_zero_%d_%s", sizes[s], v == 0 ? "specialized" : "generic");
+            report(name, bytes, (long long)BENCH_KERNEL_SAMPLES * batch * bytes, nowNs() - t, extra);
+        }
+    }
+    if (dst[maxBytes - 1] != 0) {
+        fprintf(stderr, "Noyau de remise à zéro incorrect\n");
+    }
+
+    // Les recherches ne dépendent pas de la taille de bloc : mots de 64 bits contre octets
+    static char usage[TOTAL_BLOCKS];
+    for (int i = 0; i < TOTAL_BLOCKS; ++i) {
+        usage[i] = i % 64 < 48 ? '1' : '0';
+    }
+    const BlockKernels* variants[] = {selectBlockKernels(BLOCK_SIZE), genericBlockKernels()};
+    for (int v = 0; v < 2; ++v) {
+        const BlockKernels* k = variants[v];
+        char name[64];
+        char extra[96];
+        snprintf(extra, sizeof(extra), ", \"kernels\": \"%s\"", k->name);
+        long long runs = 0;
+        long long t = nowNs();
+        for (int i = 0; i < BENCH_SCAN_CALLS; ++i) {
+            long long start = nowNs();
+            for (int b = k->next_free(usage, 0, TOTAL_BLOCKS); b < TOTAL_BLOCKS;
+                 b = k->next_free(usage, k->next_used(usage, b, TOTAL_BLOCKS), TOTAL_BLOCKS)) {
+                ++runs;
+            }
+            addSample(nowNs() - start);
+        }
+        if (runs != (long long)BENCH_SCAN_CALLS * (TOTAL_BLOCKS / 64)) {
+            fprintf(stderr, "Recherche incorrecte : %lld zones libres\n", runs);
+        }
+        snprintf(name, sizeof(name), "kernel_scan_%s", v == 0 ? "specialized" : "generic");
+        report(name, 0, (long long)BENCH_SCAN_CALLS * TOTAL_BLOCKS, nowNs() - t, extra);
+    }
+    free(src);
+    free(dst);
+}
+
+/**
+ * @brief Programme principal du banc d'essai.
+ *
+ * @param argc Nombre d'arguments.
+ * @param argv Fichier de sortie JSON facultatif.
+ * @return 0 en cas de réussite.
+ */
+int main(int argc, char** argv) {
+    // Garder la vraie sortie standard pour le JSON, faire taire la bibliothèque
+    g_json = argc > 1 ? fopen(argv[1], "w") : fdopen(dup(STDOUT_FILENO), "w");
+    if (!g_json || !freopen("/dev/null", "w", stdout)) {
+        perror("Échec de la préparation de la sortie");
+        return 1;
+    }
+
+    char dir[] = "/tmp/projet-os-bench-XXXXXX";
+    if (!mkdtemp(dir) || chdir(dir) != 0) {
+        perror("Échec de la création du répertoire de test");
+        return 1;
+    }
+
+    char* text = (char*)malloc(BENCH_FILE_SIZE);
+    char* random = (char*)malloc(BENCH_FILE_SIZE);
+    srand(BENCH_SEED);
+    fillLog(text, BENCH_FILE_SIZE);
+    for (int i = 0; i < BENCH_FILE_SIZE; ++i) {
+        random[i] = (char)rand();
+    }
+
+    fprintf(g_json, "{\n  \"block_size\": %d,\n  \"partition_size\": %d,\n  \"results\": [", BLOCK_SIZE, PARTITION_SIZE);
+
+    benchIo("", random);
+    setCompression(1);
+    benchIo("compressed_", text);
+    setCompression(0);
+    benchIo("uncompressed_text_", text);
+    benchAllocatorChurn();
+    benchSmallFiles(random);
+    benchLargeCopy(random);
+    benchDedup(random);
+    benchKernels();
+
+    fprintf(g_json, "\n  ]\n}\n");
+    fclose(g_json);
+
+    flushDiscards();
+    remove("bench.img");
+    if (chdir("/") != 0 || rmdir(dir) != 0) {
+        fprintf(stderr, "Répertoire de test non supprimé : %s\n", dir);
+    }
+    free(text);
+    free(random);
+    free(g_samples);
+    return 0;
+}
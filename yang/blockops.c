@@ -0,0 +1,264 @@
+/**
+ * @file blockops.c
+ * @brief Noyaux de traitement des blocs, spécialisés pour 512, 4096 et 65536 octets.
+ *
+ * Pour les blocs de 512 octets, la copie et la remise à zéro sont des boucles
+ * à taille constante que le compilateur déroule entièrement, par pas de 64
+ * (SSE2) ou 128 octets (AVX2) : elles évitent l'aiguillage
+ * par taille de memcpy, qui pèse sur des copies aussi courtes. Pour 4096 et
+ * 65536 octets, memcpy et memset (rep movsb/stosb) sont déjà au débit de la
+ * mémoire et sont conservés. Dans tous les cas, les recherches dans la table
+ * d'occupation comparent huit entrées à la fois. Les noyaux génériques
+ * (memcpy, memset, parcours octet par octet) servent pour les autres tailles
+ * et de référence aux bancs d'essai.
+ */
+
+#include "blockops.h"
+#include <stdint.h>
+#include <string.h> // pour memcpy, memset
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define BLOCKOPS_X86 1
+#endif
+
+#define KERNEL_STEP 64 /**< Octets copiés ou remis à zéro par itération (SSE2) */
+#define KERNEL_STEP_AVX2 128 /**< Octets copiés ou remis à zéro par itération (AVX2) */
+#define USAGE_FREE_WORD 0x3030303030303030ULL /**< Huit entrées libres ('0') */
+#define BYTE_LOW_BITS 0x0101010101010101ULL
+#define BYTE_HIGH_BITS 0x8080808080808080ULL
+
+/**
+ * @brief Copie `blocks` blocs de `size` octets (taille constante à l'appel).
+ */
+static inline __attribute__((always_inline))
+void copyUnrolled(char* dst, const char* src, size_t blocks, size_t size) {
+    for (size_t b = 0; b < blocks; ++b, dst += size, src += size) {
+#pragma GCC unroll 8
+        for (size_t i = 0; i < size; i += KERNEL_STEP) {
+#ifdef BLOCKOPS_X86
+            __m128i x0 = _mm_loadu_si128((const __m128i*)(src + i));
+            __m128i x1 = _mm_loadu_si128((const __m128i*)(src + i + 16));
+            __m128i x2 = _mm_loadu_si128((const __m128i*)(src + i + 32));
+            __m128i x3 = _mm_loadu_si128((const __m128i*)(src + i + 48));
+            _mm_storeu_si128((__m128i*)(dst + i), x0);
+            _mm_storeu_si128((__m128i*)(dst + i + 16), x1);
+            _mm_storeu_si128((__m128i*)(dst + i + 32), x2);
+            _mm_storeu_si128((__m128i*)(dst + i + 48), x3);
+#else
+            memcpy(dst + i, src + i, KERNEL_STEP);
+#endif
+        }
+    }
+}
+
+/**
+ * @brief Remet à zéro `blocks` blocs de `size` octets (taille constante à l'appel).
+ */
+static inline __attribute__((always_inline))
+void zeroUnrolled(char* dst, size_t blocks, size_t size) {
+#ifdef BLOCKOPS_X86
+    __m128i zero = _mm_setzero_si128();
+#endif
+    for (size_t b = 0; b < blocks; ++b, dst += size) {
+#pragma GCC unroll 8
+        for (size_t i = 0; i < size; i += KERNEL_STEP) {
+#ifdef BLOCKOPS_X86
+            _mm_storeu_si128((__m128i*)(dst + i), zero);
+            _mm_storeu_si128((__m128i*)(dst + i + 16), zero);
+            _mm_storeu_si128((__m128i*)(dst + i + 32), zero);
+            _mm_storeu_si128((__m128i*)(dst + i + 48), zero);
+#else
+            memset(dst + i, 0, KERNEL_STEP);
+#endif
+        }
+    }
+}
+
+#ifdef BLOCKOPS_X86
+/**
+ * @brief Copie `blocks` blocs de `size` octets avec AVX2 (taille constante à l'appel).
+ */
+static inline __attribute__((always_inline, target("avx2")))
+void copyUnrolledAvx2(char* dst, const char* src, size_t blocks, size_t size) {
+    for (size_t b = 0; b < blocks; ++b, dst += size, src += size) {
+#pragma GCC unroll 4
+        for (size_t i = 0; i < size; i += KERNEL_STEP_AVX2) {
+            __m256i y0 = _mm256_loadu_si256((const __m256i*)(src + i));
+            __m256i y1 = _mm256_loadu_si256((const __m256i*)(src + i + 32));
+            __m256i y2 = _mm256_loadu_si256((const __m256i*)(src + i + 64));
+            __m256i y3 = _mm256_loadu_si256((const __m256i*)(src + i + 96));
+            _mm256_storeu_si256((__m256i*)(dst + i), y0);
+            _mm256_storeu_si256((__m256i*)(dst + i + 32), y1);
+            _mm256_storeu_si256((__m256i*)(dst + i + 64), y2);
+            _mm256_storeu_si256((__m256i*)(dst + i + 96), y3);
+        }
+    }
+}
+
+/**
+ * @brief Remet à zéro `blocks` blocs de `size` octets avec AVX2 (taille constante à l'appel).
+ */
+static inline __attribute__((always_inline, target("avx2")))
+void zeroUnrolledAvx2(char* dst, size_t blocks, size_t size) {
+    __m256i zero = _mm256_setzero_si256();
+    for (size_t b = 0; b < blocks; ++b, dst += size) {
+#pragma GCC unroll 4
+        for (size_t i = 0; i < size; i += KERNEL_STEP_AVX2) {
+            _mm256_storeu_si256((__m256i*)(dst + i), zero);
+            _mm256_storeu_si256((__m256i*)(dst + i + 32), zero);
+            _mm256_storeu_si256((__m256i*)(dst + i + 64), zero);
+            _mm256_storeu_si256((__m256i*)(dst + i + 96), zero);
+        }
+    }
+}
+#endif
+
+/**
+ * @brief Lit huit entrées de la table d'occupation, la première dans l'octet de poids faible.
+ *
+ * Sur une machine gros-boutiste le mot est retourné : la retenue de la
+ * recherche d'octet nul ne se propage que vers les entrées suivantes, et
+ * la première entrée marquée reste exacte.
+ */
+static inline uint64_t readUsage(const char* p) {
+    uint64_t v;
+    memcpy(&v, p, sizeof(v));
+#if __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+    v = __builtin_bswap64(v);
+#endif
+    return v;
+}
+
+/**
+ * @brief Rang de la première entrée marquée (octet de poids fort à 1) d'un mot lu par readUsage.
+ */
+static inline int firstMarked(uint64_t marks) {
+    return __builtin_ctzll(marks) >> 3;
+}
+
+/**
+ * @brief Premier bloc libre de [from, end[, huit entrées à la fois.
+ */
+static int nextFreeWide(const char* usage, int from, int end) {
+    int i = from;
+    for (; i + 8 <= end; i += 8) {
+        uint64_t x = readUsage(usage + i) ^ USAGE_FREE_WORD;  // Entrée libre -> octet nul
+        uint64_t marks = (x - BYTE_LOW_BITS) & ~x & BYTE_HIGH_BITS;
+        if (marks) {
+            return i + firstMarked(marks);
+        }
+    }
+    for (; i < end && usage[i] != '0'; ++i) {
+    }
+    return i;
+}
+
+/**
+ * @brief Premier bloc occupé de [from, end[, huit entrées à la fois.
+ */
+static int nextUsedWide(const char* usage, int from, int end) {
+    int i = from;
+    for (; i + 8 <= end; i += 8) {
+        uint64_t x = readUsage(usage + i) ^ USAGE_FREE_WORD;  // Entrée occupée -> octet non nul
+        if (x) {
+            uint64_t marks = (((x & ~BYTE_HIGH_BITS) + ~BYTE_HIGH_BITS) | x) & BYTE_HIGH_BITS;
+            return i + firstMarked(marks);
+        }
+    }
+    for (; i < end && usage[i] == '0'; ++i) {
+    }
+    return i;
+}
+
+#define SMALL_BLOCK 512 /**< Taille dont la copie et la remise à zéro sont déroulées */
+
+static void copyBlocks512(void* dst, const void* src, size_t bytes) {
+    copyUnrolled((char*)dst, (const char*)src, bytes / SMALL_BLOCK, SMALL_BLOCK);
+}
+
+static void zeroBlocks512(void* dst, size_t bytes) {
+    zeroUnrolled((char*)dst, bytes / SMALL_BLOCK, SMALL_BLOCK);
+}
+
+#ifdef BLOCKOPS_X86
+__attribute__((target("avx2")))
+static void copyBlocksAvx2512(void* dst, const void* src, size_t bytes) {
+    copyUnrolledAvx2((char*)dst, (const char*)src, bytes / SMALL_BLOCK, SMALL_BLOCK);
+}
+
+__attribute__((target("avx2")))
+static void zeroBlocksAvx2512(void* dst, size_t bytes) {
+    zeroUnrolledAvx2((char*)dst, bytes / SMALL_BLOCK, SMALL_BLOCK);
+}
+#endif
+
+static void copyBlocksGeneric(void* dst, const void* src, size_t bytes) {
+    memcpy(dst, src, bytes);
+}
+
+static void zeroBlocksGeneric(void* dst, size_t bytes) {
+    memset(dst, 0, bytes);
+}
+
+static int nextFreeGeneric(const char* usage, int from, int end) {
+    int i = from;
+    while (i < end && usage[i] != '0') {
+        ++i;
+    }
+    return i;
+}
+
+static int nextUsedGeneric(const char* usage, int from, int end) {
+    int i = from;
+    while (i < end && usage[i] == '0') {
+        ++i;
+    }
+    return i;
+}
+
+static const BlockKernels kKernelsGeneric = {
+    0, "generic", copyBlocksGeneric, zeroBlocksGeneric, nextFreeGeneric, nextUsedGeneric,
+};
+
+static const BlockKernels kKernels512 = {
+    512, "bs512-sse2", copyBlocks512, zeroBlocks512, nextFreeWide, nextUsedWide,
+};
+
+#ifdef BLOCKOPS_X86
+static const BlockKernels kKernelsAvx2512 = {
+    512, "bs512-avx2", copyBlocksAvx2512, zeroBlocksAvx2512, nextFreeWide, nextUsedWide,
+};
+#endif
+
+static const BlockKernels kKernels4096 = {
+    4096, "bs4096", copyBlocksGeneric, zeroBlocksGeneric, nextFreeWide, nextUsedWide,
+};
+
+static const BlockKernels kKernels65536 = {
+    65536, "bs65536", copyBlocksGeneric, zeroBlocksGeneric, nextFreeWide, nextUsedWide,
+};
+
+const BlockKernels* g_blockKernels = &kKernelsGeneric;
+
+const BlockKernels* selectBlockKernels(int blockSize) {
+#ifdef BLOCKOPS_X86
+    if (blockSize == 512 && __builtin_cpu_supports("avx2")) {
+        return &kKernelsAvx2512;
+    }
+#endif
+    switch (blockSize) {
+        case 512:
+            return &kKernels512;
+        case 4096:
+            return &kKernels4096;
+        case 65536:
+            return &kKernels65536;
+        default:
+            return &kKernelsGeneric;
+    }
+}
+
+const BlockKernels* genericBlockKernels(void) {
+    return &kKernelsGeneric;
+}
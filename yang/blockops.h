@@ -0,0 +1,75 @@
+/**
+ * @file blockops.h
+ * @brief Calculs d'adresses et noyaux de traitement des blocs spécialisés par taille.
+ *
+ * Le calcul d'adresses (bloc d'un octet, position dans le bloc) est fait
+ * par décalage et masque, fixés à la compilation pour les tailles de bloc
+ * courantes. Les traitements en masse (copie et remise à zéro de blocs
+ * entiers, recherche dans la table d'occupation) passent par une table de
+ * fonctions choisie une fois au montage de la partition.
+ */
+
+#ifndef BLOCKOPS_H
+#define BLOCKOPS_H
+
+#include "test.h"
+#include <stddef.h>
+
+#if BLOCK_SIZE == 512
+#define BLOCK_SHIFT 9 /**< log2(BLOCK_SIZE) */
+#elif BLOCK_SIZE == 4096
+#define BLOCK_SHIFT 12 /**< log2(BLOCK_SIZE) */
+#elif BLOCK_SIZE == 65536
+#define BLOCK_SHIFT 16 /**< log2(BLOCK_SIZE) */
+#endif
+
+#ifdef BLOCK_SHIFT
+#define BLOCK_MASK (BLOCK_SIZE - 1) /**< Position dans un bloc */
+
+/** Bloc contenant l'octet `offset` (positif). */
+static inline int blockIndex(long long offset) { return (int)(offset >> BLOCK_SHIFT); }
+/** Position de l'octet `offset` (positif) dans son bloc. */
+static inline int blockOffset(long long offset) { return (int)(offset & BLOCK_MASK); }
+/** Nombre de blocs nécessaires pour `bytes` octets. */
+static inline int blocksFor(long long bytes) { return (int)((bytes + BLOCK_MASK) >> BLOCK_SHIFT); }
+#else
+static inline int blockIndex(long long offset) { return (int)(offset / BLOCK_SIZE); }
+static inline int blockOffset(long long offset) { return (int)(offset % BLOCK_SIZE); }
+static inline int blocksFor(long long bytes) { return (int)((bytes + BLOCK_SIZE - 1) / BLOCK_SIZE); }
+#endif
+
+/**
+ * @brief Noyaux de traitement des blocs pour une taille donnée.
+ */
+typedef struct {
+    int block_size; /**< Taille de bloc visée, 0 pour les noyaux génériques */
+    const char* name; /**< Nom pour les bancs d'essai */
+    /** Copie `bytes` octets (multiple de block_size) entre deux tampons disjoints. */
+    void (*copy_blocks)(void* dst, const void* src, size_t bytes);
+    /** Remet à zéro `bytes` octets (multiple de block_size). */
+    void (*zero_blocks)(void* dst, size_t bytes);
+    /** Premier bloc libre ('0') de [from, end[, end s'il n'y en a pas. */
+    int (*next_free)(const char* usage, int from, int end);
+    /** Premier bloc occupé (différent de '0') de [from, end[, end s'il n'y en a pas. */
+    int (*next_used)(const char* usage, int from, int end);
+} BlockKernels;
+
+/**
+ * @brief Noyaux de la partition montée (choisis par initializePartitionStatus).
+ */
+extern const BlockKernels* g_blockKernels;
+
+/**
+ * @brief Choisit les noyaux d'une taille de bloc.
+ * @param blockSize La taille de bloc.
+ * @return Les noyaux spécialisés pour 512, 4096 et 65536 octets, les génériques sinon.
+ */
+const BlockKernels* selectBlockKernels(int blockSize);
+
+/**
+ * @brief Noyaux génériques (taille quelconque), référence des bancs d'essai.
+ * @return Les noyaux génériques.
+ */
+const BlockKernels* genericBlockKernels(void);
+
+#endif // BLOCKOPS_H
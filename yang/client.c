@@ -0,0 +1,474 @@
+/**
+ * @file client.c
+ * @brief Implémentation de la bibliothèque cliente du serveur de partition.
+ *
+ * Les réponses arrivent dans l'ordre des requêtes : il suffit de retenir,
+ * pour chaque requête en attente, où ranger les octets lus. Les données
+ * volumineuses passent par la mémoire partagée, découpée au fil des
+ * requêtes et réutilisée dès qu'aucune requête n'y fait plus référence.
+ */
+
+#define _GNU_SOURCE // pour memfd_create
+#include "client.h"
+#include <errno.h>
+#include <poll.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#define CLIENT_SEND_FLUSH (256 * 1024) /**< Envoi automatique au-delà de cette taille en file */
+#define CLIENT_RECV_SIZE (PROTO_INLINE_MAX + 4096) /**< Tampon de réception (une réponse complète au moins) */
+#define CLIENT_TRANSFER_WINDOW 64 /**< Morceaux d'une grande lecture ou écriture en attente au plus */
+
+/**
+ * @brief Requête en attente de réponse.
+ */
+typedef struct {
+    void* readBuffer; /**< Destination des octets lus, NULL si aucune */
+    int64_t readLength; /**< Octets demandés */
+    int64_t result; /**< Résultat, une fois la réponse reçue */
+} PendingRequest;
+
+struct FsClient {
+    int fd; /**< Socket connectée au serveur */
+    int broken; /**< 1 si la connexion est perdue */
+    uint32_t nextId; /**< Numéro de la prochaine requête */
+    uint32_t completed; /**< Numéro de la dernière réponse reçue */
+    PendingRequest pending[FS_PIPELINE_MAX]; /**< Requêtes en attente, indexées par numéro */
+    char* send; /**< Requêtes pas encore envoyées */
+    size_t sendLength; /**< Octets valides dans send */
+    size_t sendCapacity; /**< Taille de send */
+    char recv[CLIENT_RECV_SIZE]; /**< Octets reçus, pas encore traités */
+    size_t recvLength; /**< Octets valides dans recv */
+    char* shm; /**< Mémoire partagée avec le serveur, NULL si aucune */
+    uint32_t shmUsed; /**< Octets de la mémoire partagée réservés par les requêtes en attente */
+};
+
+/**
+ * @brief Traite les réponses complètes déjà reçues.
+ */
+static int processResponses(FsClient* c) {
+    size_t pos = 0;
+    while (c->recvLength - pos >= sizeof(ProtoResponse)) {
+        ProtoResponse resp;
+        memcpy(&resp, c->recv + pos, sizeof(resp));
+        size_t inlineLength = resp.flags & PROTO_SHM ? 0 : resp.length;
+        uint32_t expected = c->completed + 1 ? c->completed + 1 : 1;  // 0 n'est jamais attribué
+        if (inlineLength > PROTO_INLINE_MAX || resp.id != expected) {
+            c->broken = 1;
+            return -1;
+        }
+        if (c->recvLength - pos < sizeof(resp) + inlineLength) {
+            break;
+        }
+        PendingRequest* p = &c->pending[resp.id % FS_PIPELINE_MAX];
+        if (p->readBuffer && resp.length > 0) {
+            size_t n = resp.length < p->readLength ? resp.length : (size_t)p->readLength;
+            const char* src = resp.flags & PROTO_SHM ? c->shm + resp.shm_offset : c->recv + pos + sizeof(resp);
+            memcpy(p->readBuffer, src, n);
+        }
+        p->result = resp.result;
+        c->completed = resp.id;
+        pos += sizeof(resp) + inlineLength;
+    }
+    memmove(c->recv, c->recv + pos, c->recvLength - pos);
+    c->recvLength -= pos;
+    if (c->completed == c->nextId - 1) {
+        c->shmUsed = 0;  // Plus aucune requête en attente n'utilise la mémoire partagée
+    }
+    return 0;
+}
+
+/**
+ * @brief Reçoit des octets de réponse puis traite les réponses complètes.
+ * @param flags MSG_DONTWAIT pour ne pas attendre, 0 sinon.
+ */
+static int receiveResponses(FsClient* c, int flags) {
+    ssize_t n = recv(c->fd, c->recv + c->recvLength, sizeof(c->recv) - c->recvLength, flags);
+    if (n < 0 && (errno == EINTR || errno == EAGAIN || errno == EWOULDBLOCK)) {
+        return 0;
+    }
+    if (n <= 0) {
+        c->broken = 1;
+        return -1;
+    }
+    c->recvLength += n;
+    return processResponses(c);
+}
+
+/**
+ * @brief Envoie un tampon en entier.
+ *
+ * Le serveur cesse de lire tant que ses réponses ne partent pas : quand la
+ * socket est pleine, on reçoit les réponses disponibles en attendant.
+ */
+static int sendAll(FsClient* c, const char* data, size_t length) {
+    while (length > 0) {
+        ssize_t n = send(c->fd, data, length, MSG_NOSIGNAL | MSG_DONTWAIT);
+        if (n < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            if (errno != EAGAIN && errno != EWOULDBLOCK) {
+                return -1;
+            }
+            struct pollfd pfd = { c->fd, POLLIN | POLLOUT, 0 };
+            if (poll(&pfd, 1, -1) < 0 && errno != EINTR) {
+                return -1;
+            }
+            if ((pfd.revents & POLLIN) && receiveResponses(c, MSG_DONTWAIT) == -1) {
+                return -1;
+            }
+            continue;
+        }
+        data += n;
+        length -= n;
+    }
+    return 0;
+}
+
+int fsFlush(FsClient* c) {
+    if (c->broken) {
+        return -1;
+    }
+    if (c->sendLength > 0 && sendAll(c, c->send, c->sendLength) == -1) {
+        c->broken = 1;
+        return -1;
+    }
+    c->sendLength = 0;
+    return 0;
+}
+
+/**
+ * @brief Reçoit des réponses jusqu'à celle de la requête `id`.
+ */
+static int receiveUntil(FsClient* c, uint32_t id) {
+    if (processResponses(c) == -1) {
+        return -1;
+    }
+    while ((int32_t)(c->completed - id) < 0) {
+        if (receiveResponses(c, 0) == -1) {
+            return -1;
+        }
+    }
+    return 0;
+}
+
+int64_t fsWait(FsClient* c, uint32_t id) {
+    if (id == 0 || (int32_t)(id - c->nextId) >= 0) {
+        return -1;
+    }
+    if ((int32_t)(c->completed - id) < 0 && (fsFlush(c) == -1 || receiveUntil(c, id) == -1)) {
+        return -1;
+    }
+    return c->pending[id % FS_PIPELINE_MAX].result;
+}
+
+/**
+ * @brief Réserve une zone de la mémoire partagée pour une requête.
+ * @return La position de la zone, -1 si la mémoire partagée est indisponible.
+ */
+static int64_t reserveShared(FsClient* c, uint32_t size) {
+    if (!c->shm || size > PROTO_SHM_SIZE) {
+        return -1;
+    }
+    if (c->shmUsed + size > PROTO_SHM_SIZE) {
+        fsWait(c, c->nextId - 1);  // Attendre que les requêtes en cours libèrent la mémoire
+        if (c->broken) {
+            return -1;
+        }
+    }
+    int64_t offset = c->shmUsed;
+    c->shmUsed += (size + 63) & ~63U;  // Zones alignées sur une ligne de cache
+    return offset;
+}
+
+uint32_t fsSubmit(FsClient* c, ProtoOp op, int handle, int64_t arg0, int64_t arg1,
+                  const void* data, uint32_t length, void* readBuffer) {
+    if (c->broken) {
+        return 0;
+    }
+    // Garder au plus FS_PIPELINE_MAX requêtes en attente
+    if (c->nextId - c->completed > FS_PIPELINE_MAX - 1) {
+        fsWait(c, c->completed + 1);
+        if (c->broken) {
+            return 0;
+        }
+    }
+
+    ProtoRequest req;
+    memset(&req, 0, sizeof(req));
+    req.length = length;
+    req.op = (uint8_t)op;
+    req.handle = handle;
+    req.arg0 = arg0;
+    req.arg1 = arg1;
+
+    uint32_t shmSize = op == PROTO_READ ? (uint32_t)(arg0 > 0 ? arg0 : 0) : length;
+    if (shmSize > PROTO_INLINE_MAX) {
+        int64_t offset = reserveShared(c, shmSize);
+        if (offset < 0) {
+            return 0;
+        }
+        req.flags = PROTO_SHM;
+        req.shm_offset = (uint32_t)offset;
+        if (op != PROTO_READ) {
+            memcpy(c->shm + offset, data, length);
+        }
+    }
+
+    size_t inlineLength = req.flags & PROTO_SHM ? 0 : length;
+    size_t needed = c->sendLength + sizeof(req) + inlineLength;
+    if (needed > c->sendCapacity) {
+        size_t size = c->sendCapacity ? c->sendCapacity : CLIENT_SEND_FLUSH + PROTO_INLINE_MAX;
+        while (size < needed) {
+            size *= 2;
+        }
+        char* grown = (char*)realloc(c->send, size);
+        if (!grown) {
+            return 0;
+        }
+        c->send = grown;
+        c->sendCapacity = size;
+    }
+
+    req.id = c->nextId++;
+    if (c->nextId == 0) {
+        c->nextId = 1;  // 0 est réservé aux échecs de fsSubmit
+    }
+    PendingRequest* p = &c->pending[req.id % FS_PIPELINE_MAX];
+    p->readBuffer = op == PROTO_READ ? readBuffer : NULL;
+    p->readLength = arg0;
+    p->result = -1;
+
+    memcpy(c->send + c->sendLength, &req, sizeof(req));
+    if (inlineLength > 0) {
+        memcpy(c->send + c->sendLength + sizeof(req), data, inlineLength);
+    }
+    c->sendLength = needed;
+    if (c->sendLength >= CLIENT_SEND_FLUSH) {
+        fsFlush(c);
+    }
+    return req.id;
+}
+
+/**
+ * @brief Crée la mémoire partagée et la transmet au serveur.
+ */
+static int attachSharedMemory(FsClient* c) {
+    int fd = memfd_create("fs-client", MFD_CLOEXEC);
+    if (fd < 0) {
+        return -1;
+    }
+    void* shm = MAP_FAILED;
+    if (ftruncate(fd, PROTO_SHM_SIZE) == 0) {
+        shm = mmap(NULL, PROTO_SHM_SIZE, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    }
+    if (shm == MAP_FAILED) {
+        close(fd);
+        return -1;
+    }
+
+    ProtoRequest req;
+    memset(&req, 0, sizeof(req));
+    req.op = PROTO_ATTACH;
+    req.id = c->nextId++;
+    c->pending[req.id % FS_PIPELINE_MAX].readBuffer = NULL;
+
+    struct iovec iov = { &req, sizeof(req) };
+    union {
+        char buffer[CMSG_SPACE(sizeof(int))];
+        struct cmsghdr align;
+    } control;
+    memset(&control, 0, sizeof(control));
+    struct msghdr msg;
+    memset(&msg, 0, sizeof(msg));
+    msg.msg_iov = &iov;
+    msg.msg_iovlen = 1;
+    msg.msg_control = control.buffer;
+    msg.msg_controllen = sizeof(control.buffer);
+    struct cmsghdr* cmsg = CMSG_FIRSTHDR(&msg);
+    cmsg->cmsg_level = SOL_SOCKET;
+    cmsg->cmsg_type = SCM_RIGHTS;
+    cmsg->cmsg_len = CMSG_LEN(sizeof(int));
+    memcpy(CMSG_DATA(cmsg), &fd, sizeof(fd));
+
+    ssize_t sent = sendmsg(c->fd, &msg, MSG_NOSIGNAL);
+    close(fd);  // Le serveur a désormais sa propre copie du descripteur
+    if (sent != sizeof(req)) {
+        c->broken = 1;
+    }
+    if (c->broken || fsWait(c, req.id) != 0) {
+        munmap(shm, PROTO_SHM_SIZE);
+        return -1;
+    }
+    c->shm = (char*)shm;
+    return 0;
+}
+
+FsClient* fsConnect(const char* socketPath) {
+    struct sockaddr_un addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    if (strlen(socketPath) >= sizeof(addr.sun_path)) {
+        fprintf(stderr, "Chemin de socket trop long : %s\n", socketPath);
+        return NULL;
+    }
+    strcpy(addr.sun_path, socketPath);
+
+    FsClient* c = (FsClient*)calloc(1, sizeof(FsClient));
+    if (!c) {
+        return NULL;
+    }
+    c->nextId = 1;
+    c->fd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (c->fd < 0 || connect(c->fd, (struct sockaddr*)&addr, sizeof(addr)) != 0) {
+        perror("Échec de la connexion au serveur");
+        if (c->fd >= 0) {
+            close(c->fd);
+        }
+        free(c);
+        return NULL;
+    }
+    // Sans mémoire partagée, seules les données de moins de PROTO_INLINE_MAX octets passent
+    if (attachSharedMemory(c) == -1 && c->broken) {
+        fsDisconnect(c);
+        return NULL;
+    }
+    return c;
+}
+
+void fsDisconnect(FsClient* c) {
+    if (!c) {
+        return;
+    }
+    fsFlush(c);
+    close(c->fd);
+    if (c->shm) {
+        munmap(c->shm, PROTO_SHM_SIZE);
+    }
+    free(c->send);
+    free(c);
+}
+
+/**
+ * @brief Envoie une requête et attend son résultat.
+ */
+static int64_t call(FsClient* c, ProtoOp op, int handle, int64_t arg0, int64_t arg1,
+                    const void* data, uint32_t length, void* readBuffer) {
+    uint32_t id = fsSubmit(c, op, handle, arg0, arg1, data, length, readBuffer);
+    return id ? fsWait(c, id) : -1;
+}
+
+/**
+ * @brief Envoie une requête portant deux noms séparés par un zéro.
+ */
+static int callWithNames(FsClient* c, ProtoOp op, const char* name0, const char* name1) {
+    size_t len0 = strlen(name0);
+    size_t len1 = strlen(name1);
+    if (len0 > PROTO_NAME_MAX || len1 > PROTO_NAME_MAX) {
+        return -1;
+    }
+    char names[2 * (PROTO_NAME_MAX + 1)];
+    memcpy(names, name0, len0 + 1);
+    memcpy(names + len0 + 1, name1, len1 + 1);
+    return (int)call(c, op, 0, 0, 0, names, (uint32_t)(len0 + len1 + 2), NULL);
+}
+
+int fsFormat(FsClient* c, const char* partitionName) {
+    return (int)call(c, PROTO_FORMAT, 0, 0, 0, partitionName, (uint32_t)strlen(partitionName) + 1, NULL);
+}
+
+int fsOpen(FsClient* c, const char* fileName) {
+    return (int)call(c, PROTO_OPEN, 0, 0, 0, fileName, (uint32_t)strlen(fileName) + 1, NULL);
+}
+
+int fsClose(FsClient* c, int handle) {
+    return (int)call(c, PROTO_CLOSE, handle, 0, 0, NULL, 0, NULL);
+}
+
+/**
+ * @brief Lit ou écrit par morceaux qu'une seule requête peut porter.
+ *
+ * Un morceau fait au plus PROTO_SHM_SIZE octets avec la mémoire partagée,
+ * PROTO_INLINE_MAX sans. Les morceaux partent en pipeline, chacun avec la
+ * position où il doit commencer : après un morceau incomplet ou en échec,
+ * le serveur refuse les suivants. Le total s'arrête à ce morceau.
+ */
+static int transfer(FsClient* c, ProtoOp op, int handle, char* buffer, int nBytes) {
+    int chunk = c->shm ? PROTO_SHM_SIZE : PROTO_INLINE_MAX;
+    int chunks = (nBytes + chunk - 1) / chunk;
+    int64_t start = -1;  // Un seul morceau : pas de position à vérifier
+    if (chunks > 1) {
+        start = call(c, PROTO_SEEK, handle, 0, SEEK_CUR, NULL, 0, NULL);
+        if (start < 0) {
+            return -1;
+        }
+    }
+    uint32_t ids[CLIENT_TRANSFER_WINDOW];
+    int submitted = 0;
+    int total = 0;
+    for (int done = 0; done < chunks; ++done) {
+        while (submitted < chunks && submitted - done < CLIENT_TRANSFER_WINDOW) {
+            int offset = submitted * chunk;
+            int length = nBytes - offset < chunk ? nBytes - offset : chunk;
+            int64_t expected = start + offset + 1;  // Position attendue + 1, 0 sans vérification
+            ids[submitted % CLIENT_TRANSFER_WINDOW] = op == PROTO_READ
+                ? fsSubmit(c, op, handle, length, expected, NULL, 0, buffer + offset)
+                : fsSubmit(c, op, handle, 0, expected, buffer + offset, (uint32_t)length, NULL);
+            ++submitted;
+        }
+        uint32_t id = ids[done % CLIENT_TRANSFER_WINDOW];
+        int64_t result = id ? fsWait(c, id) : -1;
+        if (result < 0) {
+            return total > 0 ? total : -1;
+        }
+        total += (int)result;
+        if (result < (done + 1 < chunks ? chunk : nBytes - done * chunk)) {
+            break;  // Fin du fichier ou partition pleine : le serveur a refusé les morceaux suivants
+        }
+    }
+    return total;
+}
+
+int fsWrite(FsClient* c, int handle, const void* buffer, int nBytes) {
+    if (nBytes < 1) {
+        return -1;
+    }
+    return transfer(c, PROTO_WRITE, handle, (char*)buffer, nBytes);
+}
+
+int fsRead(FsClient* c, int handle, void* buffer, int nBytes) {
+    if (nBytes < 1) {
+        return -1;
+    }
+    return transfer(c, PROTO_READ, handle, (char*)buffer, nBytes);
+}
+
+int fsSeek(FsClient* c, int handle, int offset, int base) {
+    return (int)call(c, PROTO_SEEK, handle, offset, base, NULL, 0, NULL);
+}
+
+int fsSize(FsClient* c, int handle) {
+    return (int)call(c, PROTO_SIZE, handle, 0, 0, NULL, 0, NULL);
+}
+
+int fsDelete(FsClient* c, int handle) {
+    return (int)call(c, PROTO_DELETE, handle, 0, 0, NULL, 0, NULL);
+}
+
+int fsCopy(FsClient* c, const char* sourceName, const char* destName) {
+    return callWithNames(c, PROTO_COPY, sourceName, destName);
+}
+
+int fsRename(FsClient* c, const char* oldName, const char* newName) {
+    return callWithNames(c, PROTO_RENAME, oldName, newName);
+}
+
+int fsMove(FsClient* c, const char* sourceName, const char* destName) {
+    return callWithNames(c, PROTO_MOVE, sourceName, destName);
+}
@@ -0,0 +1,141 @@
+/**
+ * @file client.h
+ * @brief Bibliothèque cliente du serveur de partition (server.c).
+ *
+ * Les appels synchrones (fsOpen, fsWrite...) envoient une requête et
+ * attendent sa réponse. Pour enchaîner des requêtes sans attendre chaque
+ * aller-retour, fsSubmit les accumule et fsWait récupère le résultat d'une
+ * requête donnée ; les requêtes en attente partent ensemble au premier
+ * fsWait ou fsFlush. Le résultat d'une requête doit être lu avant d'en
+ * soumettre FS_PIPELINE_MAX autres. Une connexion ne doit pas être
+ * partagée entre plusieurs fils.
+ */
+
+#ifndef CLIENT_H
+#define CLIENT_H
+
+#include "proto.h"
+#include <stdint.h>
+
+#define FS_PIPELINE_MAX 1024 /**< Requêtes en attente de réponse au plus */
+
+/**
+ * @brief Connexion au serveur (structure opaque).
+ */
+typedef struct FsClient FsClient;
+
+/**
+ * @brief Se connecte au serveur et lui transmet la mémoire partagée.
+ * @param socketPath Chemin de la socket du serveur.
+ * @return La connexion, NULL en cas d'échec.
+ */
+FsClient* fsConnect(const char* socketPath);
+
+/**
+ * @brief Ferme la connexion ; le serveur ferme les fichiers restés ouverts.
+ * @param c La connexion.
+ */
+void fsDisconnect(FsClient* c);
+
+/**
+ * @brief Met une requête en file sans attendre sa réponse.
+ * @param c La connexion.
+ * @param op L'opération.
+ * @param handle Descripteur du fichier (fsOpen), ou 0.
+ * @param arg0 Premier argument (voir ProtoOp).
+ * @param arg1 Second argument (voir ProtoOp).
+ * @param data Données à envoyer (noms, octets à écrire), ou NULL.
+ * @param length Taille des données.
+ * @param readBuffer Tampon recevant les octets lus (PROTO_READ, arg0 octets), ou NULL.
+ * @return Le numéro de la requête à passer à fsWait, 0 en cas d'échec.
+ */
+uint32_t fsSubmit(FsClient* c, ProtoOp op, int handle, int64_t arg0, int64_t arg1,
+                  const void* data, uint32_t length, void* readBuffer);
+
+/**
+ * @brief Envoie les requêtes en file.
+ * @param c La connexion.
+ * @return 0 en cas de succès, -1 si la connexion est perdue.
+ */
+int fsFlush(FsClient* c);
+
+/**
+ * @brief Attend la réponse d'une requête.
+ * @param c La connexion.
+ * @param id Numéro renvoyé par fsSubmit.
+ * @return Le résultat de la requête, -1 en cas d'échec.
+ */
+int64_t fsWait(FsClient* c, uint32_t id);
+
+/**
+ * @brief Formatte la partition du serveur.
+ * @return 0 en cas de succès, -1 en cas d'échec.
+ */
+int fsFormat(FsClient* c, const char* partitionName);
+
+/**
+ * @brief Ouvre un fichier, créé s'il n'existe pas.
+ * @return Le descripteur du fichier, -1 en cas d'échec.
+ */
+int fsOpen(FsClient* c, const char* fileName);
+
+/**
+ * @brief Ferme un fichier sans le supprimer.
+ * @return 0 en cas de succès, -1 en cas d'échec.
+ */
+int fsClose(FsClient* c, int handle);
+
+/**
+ * @brief Écrit à la position courante du fichier.
+ *
+ * Au-delà de ce qu'une requête peut porter, l'écriture est découpée en
+ * plusieurs requêtes envoyées à la suite.
+ * @return Le nombre d'octets écrits, -1 en cas d'échec.
+ */
+int fsWrite(FsClient* c, int handle, const void* buffer, int nBytes);
+
+/**
+ * @brief Lit à la position courante du fichier.
+ *
+ * Découpée comme fsWrite au-delà de ce qu'une requête peut porter.
+ * @return Le nombre d'octets lus, -1 en cas d'échec.
+ */
+int fsRead(FsClient* c, int handle, void* buffer, int nBytes);
+
+/**
+ * @brief Déplace la position courante du fichier.
+ * @return La nouvelle position, -1 en cas d'échec.
+ */
+int fsSeek(FsClient* c, int handle, int offset, int base);
+
+/**
+ * @brief Taille du fichier.
+ * @return La taille, -1 en cas d'échec.
+ */
+int fsSize(FsClient* c, int handle);
+
+/**
+ * @brief Supprime le fichier et ferme son descripteur.
+ * @return 0 en cas de succès, -1 en cas d'échec.
+ */
+int fsDelete(FsClient* c, int handle);
+
+/**
+ * @brief Copie un fichier.
+ * @return 0 en cas de succès, -1 en cas d'échec.
+ */
+int fsCopy(FsClient* c, const char* sourceName, const char* destName);
+
+/**
+ * @brief Renomme un fichier.
+ * @return 0 en cas de succès, -1 en cas d'échec.
+ */
+int fsRename(FsClient* c, const char* oldName, const char* newName);
+
+/**
+ * @brief Déplace un fichier.
+ * @return 0 en cas de succès, -1 en cas d'échec.
+ */
+int fsMove(FsClient* c, const char* sourceName, const char* destName);
+
+#endif // CLIENT_H
@@ -0,0 +1,295 @@
+/**
+ * @file clientbench.c
+ * @brief Banc d'essai du serveur de partition à travers la bibliothèque cliente (cible make clientbench).
+ *
+ * Usage : clientbench serveur [résultats.json]
+ *
+ * Lance le serveur donné dans un répertoire temporaire, vérifie quelques
+ * allers-retours (grandes lectures et écritures découpées, écriture découpée
+ * qui remplit la partition, fichier partagé entre deux connexions) puis mesure la latence des appels synchrones et
+ * en pipeline. Les résultats sont écrits en JSON comme ceux de make bench.
+ */
+
+#include "client.h"
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/wait.h>
+#include <time.h>
+#include <unistd.h>
+
+#define CLIENT_BENCH_SOCKET "server.sock" /**< Socket du serveur, dans le répertoire temporaire */
+#define CLIENT_BENCH_IMAGE "clientbench.img" /**< Partition formatée par le banc d'essai */
+#define CLIENT_BENCH_CALLS 20000 /**< Appels de chaque charge de latence */
+#define CLIENT_BENCH_BATCH 256 /**< Requêtes par lot en pipeline */
+#define CLIENT_BENCH_LARGE (600 * 1024) /**< Écriture plus grande qu'une requête dans la socket */
+#define CLIENT_BENCH_HUGE (6 * 1024 * 1024) /**< Lecture plus grande que la mémoire partagée */
+#define CLIENT_BENCH_OVERFLOW (PROTO_SHM_SIZE + 100 * 1024) /**< Écriture en deux morceaux dont le premier ne tient pas dans la partition */
+#define CLIENT_BENCH_IO 4096 /**< Taille des lectures et écritures mesurées */
+#define CLIENT_BENCH_IO_SPAN 64 /**< Opérations avant de revenir au début du fichier (256 Kio) */
+
+static FILE* g_json; /**< Flux de sortie des résultats */
+static int g_firstResult = 1; /**< Pas de virgule avant le premier résultat */
+static long long g_samples[CLIENT_BENCH_CALLS]; /**< Latences de la charge en cours (ns) */
+static int g_sampleCount; /**< Nombre de latences enregistrées */
+static pid_t g_server = -1; /**< Processus du serveur lancé */
+
+/**
+ * @brief Horloge monotone en nanosecondes.
+ */
+static long long nowNs(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000000000LL + ts.tv_nsec;
+}
+
+/**
+ * @brief Comparaison pour qsort.
+ */
+static int compareSamples(const void* a, const void* b) {
+    long long x = *(const long long*)a;
+    long long y = *(const long long*)b;
+    return (x > y) - (x < y);
+}
+
+/**
+ * @brief Centile des latences enregistrées (tableau déjà trié).
+ */
+static long long percentile(double p) {
+    if (g_sampleCount == 0) {
+        return 0;
+    }
+    return g_samples[(int)(p * (g_sampleCount - 1) + 0.5)];
+}
+
+/**
+ * @brief Écrit un résultat à partir des latences enregistrées puis les oublie.
+ *
+ * @param name Nom de la charge.
+ * @param ops Appels effectués (un échantillon peut en couvrir plusieurs).
+ * @param bytes Octets transférés pendant la charge.
+ * @param elapsedNs Durée totale de la charge.
+ */
+static void report(const char* name, int ops, long long bytes, long long elapsedNs) {
+    qsort(g_samples, g_sampleCount, sizeof(long long), compareSamples);
+    double seconds = elapsedNs / 1e9;
+    fprintf(g_json, "%s\n    {\"name\": \"%s\", \"ops\": %d, \"bytes\": %lld, \"ops_per_s\": %.1f, "
+            "\"mb_per_s\": %.3f, \"p50_ns\": %lld, \"p99_ns\": %lld, \"p999_ns\": %lld}",
+            g_firstResult ? "" : ",", name, ops, bytes,
+            seconds > 0 ? ops / seconds : 0.0,
+            seconds > 0 ? bytes / seconds / (1024.0 * 1024.0) : 0.0,
+            percentile(0.50), percentile(0.99), percentile(0.999));
+    g_firstResult = 0;
+    g_sampleCount = 0;
+}
+
+/**
+ * @brief Arrête le banc d'essai sur une vérification en échec.
+ */
+static void require(int condition, const char* message) {
+    if (!condition) {
+        fprintf(stderr, "Vérification en échec : %s\n", message);
+        if (g_server > 0) {
+            kill(g_server, SIGTERM);
+        }
+        exit(1);
+    }
+}
+
+/**
+ * @brief Lance le serveur et attend qu'il accepte les connexions.
+ * @return Le processus du serveur, -1 en cas d'échec.
+ */
+static pid_t startServer(const char* serverPath) {
+    pid_t pid = fork();
+    if (pid == 0) {
+        if (!freopen("/dev/null", "w", stderr)) {
+            _exit(127);
+        }
+        execl(serverPath, serverPath, CLIENT_BENCH_SOCKET, (char*)NULL);
+        _exit(127);
+    }
+    for (int attempt = 0; pid > 0 && attempt < 500; ++attempt) {
+        if (access(CLIENT_BENCH_SOCKET, F_OK) == 0) {
+            return pid;
+        }
+        usleep(10000);
+    }
+    perror("Échec du lancement du serveur");
+    return -1;
+}
+
+/**
+ * @brief Une grande écriture fait l'aller-retour, relue par une lecture découpée en plusieurs requêtes.
+ */
+static void checkLargeTransfer(FsClient* c) {
+    char* out = (char*)malloc(CLIENT_BENCH_LARGE);
+    char* in = (char*)malloc(CLIENT_BENCH_HUGE);
+    require(out && in, "allocation des tampons");
+    for (int i = 0; i < CLIENT_BENCH_LARGE; ++i) {
+        out[i] = (char)(i * 131 + (i >> 12));
+    }
+    int h = fsOpen(c, "large.dat");
+    require(h >= 0, "ouverture de large.dat");
+    require(fsWrite(c, h, out, CLIENT_BENCH_LARGE) == CLIENT_BENCH_LARGE, "grande écriture");
+    require(fsSeek(c, h, 0, SEEK_SET) == 0, "retour au début");
+    require(fsRead(c, h, in, CLIENT_BENCH_HUGE) == CLIENT_BENCH_LARGE, "lecture découpée jusqu'à la fin du fichier");
+    require(memcmp(in, out, CLIENT_BENCH_LARGE) == 0, "contenu relu identique");
+    require(fsDelete(c, h) == 0, "suppression de large.dat");
+    free(out);
+    free(in);
+}
+
+/**
+ * @brief Une écriture découpée qui remplit la partition en cours de route n'écrit rien au mauvais endroit.
+ *
+ * Le premier morceau dépasse l'espace libre et échoue ; le second, déjà
+ * envoyé en pipeline, tiendrait dans la partition mais doit être refusé.
+ */
+static void checkPartialPipelinedWrite(FsClient* c) {
+    char* out = (char*)calloc(1, CLIENT_BENCH_OVERFLOW);
+    require(out != NULL, "allocation du tampon");
+    int h = fsOpen(c, "overflow.dat");
+    require(h >= 0, "ouverture de overflow.dat");
+    require(fsWrite(c, h, out, CLIENT_BENCH_OVERFLOW) == -1, "écriture plus grande que la partition refusée");
+    require(fsSize(c, h) == 0, "aucun morceau écrit après le morceau en échec");
+    require(fsSeek(c, h, 0, SEEK_CUR) == 0, "position inchangée");
+    require(fsDelete(c, h) == 0, "suppression de overflow.dat");
+    free(out);
+}
+
+/**
+ * @brief Deux connexions qui ouvrent le même fichier voient les mêmes données.
+ */
+static void checkSharedFile(FsClient* a, FsClient* b) {
+    char buffer[8] = { 0 };
+    int ha = fsOpen(a, "shared.dat");
+    int hb = fsOpen(b, "shared.dat");
+    require(ha >= 0 && hb >= 0, "ouverture de shared.dat par deux connexions");
+    require(fsWrite(a, ha, "partage", 7) == 7, "écriture par la première connexion");
+    require(fsRead(b, hb, buffer, 7) == 7 && memcmp(buffer, "partage", 7) == 0,
+            "lecture par la seconde connexion");
+    require(fsDelete(a, ha) == 0, "suppression de shared.dat");
+    require(fsSize(b, hb) == -1, "descripteur d'un fichier supprimé");
+    fsClose(b, hb);
+}
+
+/**
+ * @brief Latence d'un appel synchrone (un aller-retour par appel).
+ */
+static void benchSync(FsClient* c, int h) {
+    long long t = nowNs();
+    for (int i = 0; i < CLIENT_BENCH_CALLS; ++i) {
+        long long s = nowNs();
+        fsSize(c, h);
+        g_samples[g_sampleCount++] = nowNs() - s;
+    }
+    report("client_sync_size", CLIENT_BENCH_CALLS, 0, nowNs() - t);
+}
+
+/**
+ * @brief Coût d'un appel en pipeline (échantillon : un lot divisé par sa taille).
+ */
+static void benchPipelined(FsClient* c, int h) {
+    long long t = nowNs();
+    for (int i = 0; i < CLIENT_BENCH_CALLS / CLIENT_BENCH_BATCH; ++i) {
+        long long s = nowNs();
+        uint32_t last = 0;
+        for (int j = 0; j < CLIENT_BENCH_BATCH; ++j) {
+            last = fsSubmit(c, PROTO_SIZE, h, 0, 0, NULL, 0, NULL);
+        }
+        fsWait(c, last);
+        g_samples[g_sampleCount++] = (nowNs() - s) / CLIENT_BENCH_BATCH;
+    }
+    int ops = CLIENT_BENCH_CALLS / CLIENT_BENCH_BATCH * CLIENT_BENCH_BATCH;
+    report("client_pipelined_size", ops, 0, nowNs() - t);
+}
+
+/**
+ * @brief Latence des écritures puis des lectures synchrones de CLIENT_BENCH_IO octets.
+ *
+ * Les opérations parcourent les 256 premiers Kio du fichier, qui tiennent
+ * dans la partition ; les retours au début ne sont pas mesurés.
+ */
+static void benchIo(FsClient* c, int h) {
+    static char buffer[CLIENT_BENCH_IO];
+    memset(buffer, 'x', sizeof(buffer));
+    int calls = CLIENT_BENCH_CALLS / 4;
+
+    long long elapsed = 0;
+    for (int i = 0; i < calls; ++i) {
+        if (i % CLIENT_BENCH_IO_SPAN == 0) {
+            fsSeek(c, h, 0, SEEK_SET);
+        }
+        long long s = nowNs();
+        int written = fsWrite(c, h, buffer, CLIENT_BENCH_IO);
+        g_samples[g_sampleCount++] = nowNs() - s;
+        elapsed += g_samples[g_sampleCount - 1];
+        require(written == CLIENT_BENCH_IO, "écriture mesurée");
+    }
+    report("client_write_4k", calls, (long long)calls * CLIENT_BENCH_IO, elapsed);
+
+    elapsed = 0;
+    for (int i = 0; i < calls; ++i) {
+        if (i % CLIENT_BENCH_IO_SPAN == 0) {
+            fsSeek(c, h, 0, SEEK_SET);
+        }
+        long long s = nowNs();
+        int read = fsRead(c, h, buffer, CLIENT_BENCH_IO);
+        g_samples[g_sampleCount++] = nowNs() - s;
+        elapsed += g_samples[g_sampleCount - 1];
+        require(read == CLIENT_BENCH_IO, "lecture mesurée");
+    }
+    report("client_read_4k", calls, (long long)calls * CLIENT_BENCH_IO, elapsed);
+}
+
+int main(int argc, char** argv) {
+    if (argc < 2) {
+        fprintf(stderr, "Usage : %s serveur [résultats.json]\n", argv[0]);
+        return 1;
+    }
+    char* serverPath = realpath(argv[1], NULL);
+    g_json = argc > 2 ? fopen(argv[2], "w") : stdout;
+    if (!serverPath || !g_json) {
+        perror("Échec de la préparation du banc d'essai");
+        return 1;
+    }
+    char dir[] = "/tmp/projet-os-clientbench-XXXXXX";
+    if (!mkdtemp(dir) || chdir(dir) != 0) {
+        perror("Échec de la création du répertoire de test");
+        return 1;
+    }
+
+    g_server = startServer(serverPath);
+    FsClient* a = g_server > 0 ? fsConnect(CLIENT_BENCH_SOCKET) : NULL;
+    FsClient* b = a ? fsConnect(CLIENT_BENCH_SOCKET) : NULL;
+    require(b != NULL, "connexion au serveur");
+    require(fsFormat(a, CLIENT_BENCH_IMAGE) == 0, "formatage");
+
+    checkLargeTransfer(a);
+    checkPartialPipelinedWrite(a);
+    checkSharedFile(a, b);
+
+    fprintf(g_json, "{\n  \"results\": [");
+    int h = fsOpen(a, "bench.dat");
+    benchSync(a, h);
+    benchPipelined(a, h);
+    benchIo(a, h);
+    fsDelete(a, h);
+    fprintf(g_json, "\n  ]\n}\n");
+    if (g_json != stdout) {
+        fclose(g_json);
+    }
+
+    fsDisconnect(a);
+    fsDisconnect(b);
+    kill(g_server, SIGTERM);
+    waitpid(g_server, NULL, 0);
+    remove(CLIENT_BENCH_IMAGE);
+    if (chdir("/") != 0 || rmdir(dir) != 0) {
+        fprintf(stderr, "Répertoire de test non supprimé : %s\n", dir);
+    }
+    free(serverPath);
+    return 0;
+}
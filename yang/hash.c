@@ -0,0 +1,180 @@
+/**
+ * @file hash.c
+ * @brief Implémentation de l'empreinte des blocs (scalaire, SSE2 et AVX2).
+ *
+ * Les données sont découpées en bandes de 64 octets accumulées dans huit
+ * entiers de 64 bits, à la manière de XXH3 : chaque mot est combiné avec une
+ * clé, ses deux moitiés sont multipliées entre elles et le mot brut est
+ * ajouté à l'accumulateur voisin. Cette boucle se vectorise directement.
+ */
+
+#include "hash.h"
+#include <pthread.h>
+#include <string.h> // pour memcpy, memset
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define HASH_X86 1
+#endif
+
+#define STRIPE_SIZE 64 /**< Octets traités par itération */
+#define PRIME64_1 0x9E3779B185EBCA87ULL
+#define PRIME64_2 0xC2B2AE3D27D4EB4FULL
+#define PRIME64_3 0x165667B19E3779F9ULL
+#define PRIME32_3 0xC2B2AE3DULL
+
+/** Clé combinée avec chaque bande. */
+static const uint64_t kSecret[8] = {
+    0xbe4ba423396cfeb8ULL, 0x1cad21f72c81017cULL,
+    0xdb979083e96dd4deULL, 0x1f67b3b7a4a44072ULL,
+    0x78e5c0cc4ee679cbULL, 0x2172ffcc7dd05a82ULL,
+    0x8e2443f7744608b8ULL, 0x4c263a81e69035e0ULL,
+};
+
+/**
+ * @brief Lit un mot de 64 bits non aligné.
+ */
+static inline uint64_t read64(const unsigned char* p) {
+    uint64_t v;
+    memcpy(&v, p, sizeof(v));
+    return v;
+}
+
+/**
+ * @brief Accumule une bande de 64 octets (version scalaire).
+ */
+static void accumulateScalar(uint64_t* acc, const unsigned char* p, size_t stripes) {
+    for (size_t s = 0; s < stripes; ++s, p += STRIPE_SIZE) {
+        for (int i = 0; i < 8; ++i) {
+            uint64_t d = read64(p + 8 * i);
+            uint64_t dk = d ^ kSecret[i];
+            acc[i ^ 1] += d;
+            acc[i] += (dk & 0xFFFFFFFFULL) * (dk >> 32);
+        }
+    }
+}
+
+#ifdef HASH_X86
+/**
+ * @brief Accumule des bandes de 64 octets avec SSE2 (deux voies par registre).
+ */
+__attribute__((target("sse2")))
+static void accumulateSse2(uint64_t* acc, const unsigned char* p, size_t stripes) {
+    __m128i a[4], k[4];
+    for (int i = 0; i < 4; ++i) {
+        a[i] = _mm_loadu_si128((const __m128i*)(acc + 2 * i));
+        k[i] = _mm_loadu_si128((const __m128i*)(kSecret + 2 * i));
+    }
+    for (size_t s = 0; s < stripes; ++s, p += STRIPE_SIZE) {
+        for (int i = 0; i < 4; ++i) {
+            __m128i d = _mm_loadu_si128((const __m128i*)(p + 16 * i));
+            __m128i dk = _mm_xor_si128(d, k[i]);
+            __m128i hi = _mm_shuffle_epi32(dk, _MM_SHUFFLE(0, 3, 0, 1));
+            __m128i product = _mm_mul_epu32(dk, hi);
+            __m128i swapped = _mm_shuffle_epi32(d, _MM_SHUFFLE(1, 0, 3, 2));
+            a[i] = _mm_add_epi64(a[i], _mm_add_epi64(product, swapped));
+        }
+    }
+    for (int i = 0; i < 4; ++i) {
+        _mm_storeu_si128((__m128i*)(acc + 2 * i), a[i]);
+    }
+}
+
+/**
+ * @brief Accumule des bandes de 64 octets avec AVX2 (quatre voies par registre).
+ */
+__attribute__((target("avx2")))
+static void accumulateAvx2(uint64_t* acc, const unsigned char* p, size_t stripes) {
+    __m256i a[2], k[2];
+    for (int i = 0; i < 2; ++i) {
+        a[i] = _mm256_loadu_si256((const __m256i*)(acc + 4 * i));
+        k[i] = _mm256_loadu_si256((const __m256i*)(kSecret + 4 * i));
+    }
+    for (size_t s = 0; s < stripes; ++s, p += STRIPE_SIZE) {
+        for (int i = 0; i < 2; ++i) {
+            __m256i d = _mm256_loadu_si256((const __m256i*)(p + 32 * i));
+            __m256i dk = _mm256_xor_si256(d, k[i]);
+            __m256i hi = _mm256_shuffle_epi32(dk, _MM_SHUFFLE(0, 3, 0, 1));
+            __m256i product = _mm256_mul_epu32(dk, hi);
+            __m256i swapped = _mm256_shuffle_epi32(d, _MM_SHUFFLE(1, 0, 3, 2));
+            a[i] = _mm256_add_epi64(a[i], _mm256_add_epi64(product, swapped));
+        }
+    }
+    for (int i = 0; i < 2; ++i) {
+        _mm256_storeu_si256((__m256i*)(acc + 4 * i), a[i]);
+    }
+}
+#endif
+
+/** Signature commune des fonctions d'accumulation. */
+typedef void (*AccumulateFn)(uint64_t* acc, const unsigned char* p, size_t stripes);
+
+/**
+ * @brief Mélange final d'un entier de 64 bits.
+ */
+static inline uint64_t avalanche(uint64_t h) {
+    h ^= h >> 33;
+    h *= PRIME64_2;
+    h ^= h >> 29;
+    h *= PRIME64_3;
+    h ^= h >> 32;
+    return h;
+}
+
+/**
+ * @brief Calcule l'empreinte avec la fonction d'accumulation donnée.
+ */
+static uint64_t hashWith(AccumulateFn accumulate, const void* data, size_t len) {
+    const unsigned char* p = (const unsigned char*)data;
+    uint64_t acc[8] = {
+        PRIME32_3, PRIME64_1, PRIME64_2, PRIME64_3,
+        PRIME64_1 ^ len, PRIME64_2 ^ len, PRIME64_3 ^ len, PRIME32_3 ^ len,
+    };
+
+    size_t stripes = len / STRIPE_SIZE;
+    if (stripes > 0) {
+        accumulate(acc, p, stripes);
+    }
+
+    // Dernière bande incomplète : complétée par des zéros
+    size_t rest = len % STRIPE_SIZE;
+    if (rest > 0) {
+        unsigned char last[STRIPE_SIZE];
+        memset(last, 0, sizeof(last));
+        memcpy(last, p + stripes * STRIPE_SIZE, rest);
+        accumulateScalar(acc, last, 1);
+    }
+
+    uint64_t h = (uint64_t)len * PRIME64_1;
+    for (int i = 0; i < 8; ++i) {
+        h ^= avalanche(acc[i]);
+        h = ((h << 27) | (h >> 37)) * PRIME64_1 + PRIME64_2;
+    }
+    return avalanche(h);
+}
+
+uint64_t blockHashScalar(const void* data, size_t len) {
+    return hashWith(accumulateScalar, data, len);
+}
+
+static AccumulateFn g_accumulate = accumulateScalar; /**< Version choisie par selectAccumulate */
+static pthread_once_t g_accumulateOnce = PTHREAD_ONCE_INIT; /**< Choix fait une seule fois */
+
+/**
+ * @brief Choisit la version de l'accumulation selon le processeur.
+ */
+static void selectAccumulate(void) {
+#ifdef HASH_X86
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2")) {
+        g_accumulate = accumulateAvx2;
+    } else if (__builtin_cpu_supports("sse2")) {
+        g_accumulate = accumulateSse2;
+    }
+#endif
+}
+
+uint64_t blockHash(const void* data, size_t len) {
+    pthread_once(&g_accumulateOnce, selectAccumulate);  // Sûr même au premier appel de plusieurs fils
+    return hashWith(g_accumulate, data, len);
+}
@@ -0,0 +1,32 @@
+/**
+ * @file hash.h
+ * @brief Empreinte rapide du contenu des blocs pour la déduplication.
+ */
+
+#ifndef HASH_H
+#define HASH_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+/**
+ * @brief Calcule l'empreinte 64 bits d'une zone mémoire.
+ *
+ * L'implémentation vectorielle (AVX2 ou SSE2) est choisie une seule fois,
+ * au premier appel (pthread_once), selon le processeur ; toutes les
+ * variantes donnent le même résultat.
+ * @param data Pointeur vers les données.
+ * @param len Taille des données en octets.
+ * @return L'empreinte des données.
+ */
+uint64_t blockHash(const void* data, size_t len);
+
+/**
+ * @brief Calcule l'empreinte avec l'implémentation scalaire de référence.
+ * @param data Pointeur vers les données.
+ * @param len Taille des données en octets.
+ * @return L'empreinte des données, identique à celle de blockHash.
+ */
+uint64_t blockHashScalar(const void* data, size_t len);
+
+#endif // HASH_H
@@ -0,0 +1,177 @@
+/**
+ * @file lz.c
+ * @brief Implémentation du codec de type LZ4 (format de bloc, recherche gloutonne).
+ *
+ * Chaque séquence commence par un jeton : 4 bits pour la longueur des
+ * littéraux, 4 bits pour la longueur de la correspondance moins 4. Les
+ * longueurs de 15 ou plus se prolongent par des octets de 255. Viennent
+ * ensuite les littéraux puis le décalage de la correspondance sur 2 octets.
+ * La dernière séquence ne contient que des littéraux.
+ */
+
+#include "lz.h"
+#include <stdint.h>
+#include <string.h> // pour memcpy
+
+#define LZ_MIN_MATCH 4 /**< Longueur minimale d'une correspondance */
+#define LZ_HASH_LOG 12 /**< Taille de la table de recherche (log2) */
+#define LZ_LAST_LITERALS 5 /**< Les derniers octets sont toujours des littéraux */
+#define LZ_MF_LIMIT 12 /**< Aucune correspondance ne commence dans les derniers octets */
+#define LZ_MAX_OFFSET 65535 /**< Distance maximale d'une correspondance */
+
+/**
+ * @brief Lit un mot de 32 bits non aligné.
+ */
+static inline uint32_t read32(const unsigned char* p) {
+    uint32_t v;
+    memcpy(&v, p, sizeof(v));
+    return v;
+}
+
+/**
+ * @brief Empreinte de 4 octets pour la table de recherche.
+ */
+static inline int hash4(uint32_t v) {
+    return (int)((v * 2654435761U) >> (32 - LZ_HASH_LOG));
+}
+
+/**
+ * @brief Écrit le prolongement d'une longueur (octets de 255).
+ * @return Pointeur après le dernier octet écrit, NULL si le tampon est plein.
+ */
+static unsigned char* writeLength(unsigned char* op, const unsigned char* oend, int len) {
+    for (; len >= 255; len -= 255) {
+        if (op >= oend) return NULL;
+        *op++ = 255;
+    }
+    if (op >= oend) return NULL;
+    *op++ = (unsigned char)len;
+    return op;
+}
+
+/**
+ * @brief Écrit une séquence (littéraux puis correspondance éventuelle).
+ * @return Pointeur après la séquence, NULL si le tampon est plein.
+ */
+static unsigned char* writeSequence(unsigned char* op, const unsigned char* oend,
+                                    const unsigned char* literals, int litLen,
+                                    int offset, int matchLen) {
+    if (op >= oend) return NULL;
+    unsigned char* token = op++;
+    int litCode = litLen < 15 ? litLen : 15;
+    int matchCode = 0;
+    if (litLen >= 15 && !(op = writeLength(op, oend, litLen - 15))) return NULL;
+    if (op + litLen > oend) return NULL;
+    memcpy(op, literals, litLen);
+    op += litLen;
+
+    if (matchLen > 0) {
+        int code = matchLen - LZ_MIN_MATCH;
+        matchCode = code < 15 ? code : 15;
+        if (op + 2 > oend) return NULL;
+        *op++ = (unsigned char)(offset & 0xFF);
+        *op++ = (unsigned char)(offset >> 8);
+        if (code >= 15 && !(op = writeLength(op, oend, code - 15))) return NULL;
+    }
+    *token = (unsigned char)((litCode << 4) | matchCode);
+    return op;
+}
+
+int lzCompressBound(int srcSize) {
+    return srcSize + srcSize / 255 + 16;
+}
+
+int lzCompress(const char* src, int srcSize, char* dst, int dstCapacity) {
+    const unsigned char* base = (const unsigned char*)src;
+    const unsigned char* ip = base;
+    const unsigned char* anchor = base;
+    const unsigned char* end = base + srcSize;
+    unsigned char* op = (unsigned char*)dst;
+    const unsigned char* oend = op + dstCapacity;
+    int table[1 << LZ_HASH_LOG];
+
+    if (srcSize > LZ_MF_LIMIT) {
+        const unsigned char* mfLimit = end - LZ_MF_LIMIT;
+        const unsigned char* matchLimit = end - LZ_LAST_LITERALS;
+        memset(table, 0xFF, sizeof(table));  // -1 : aucune position connue
+
+        while (ip < mfLimit) {
+            uint32_t seq = read32(ip);
+            int h = hash4(seq);
+            int refPos = table[h];
+            table[h] = (int)(ip - base);
+            if (refPos < 0 || ip - (base + refPos) > LZ_MAX_OFFSET || read32(base + refPos) != seq) {
+                ++ip;
+                continue;
+            }
+
+            // Allonger la correspondance vers l'avant
+            const unsigned char* ref = base + refPos;
+            int matchLen = LZ_MIN_MATCH;
+            while (ip + matchLen < matchLimit && ref[matchLen] == ip[matchLen]) {
+                ++matchLen;
+            }
+
+            op = writeSequence(op, oend, anchor, (int)(ip - anchor), (int)(ip - ref), matchLen);
+            if (!op) return 0;
+            ip += matchLen;
+            anchor = ip;
+        }
+    }
+
+    // Dernière séquence : uniquement des littéraux
+    op = writeSequence(op, oend, anchor, (int)(end - anchor), 0, 0);
+    if (!op) return 0;
+    return (int)(op - (unsigned char*)dst);
+}
+
+int lzDecompress(const char* src, int srcSize, char* dst, int dstCapacity) {
+    const unsigned char* ip = (const unsigned char*)src;
+    const unsigned char* iend = ip + srcSize;
+    unsigned char* op = (unsigned char*)dst;
+    unsigned char* oend = op + dstCapacity;
+
+    while (ip < iend) {
+        int token = *ip++;
+
+        int litLen = token >> 4;
+        if (litLen == 15) {
+            int b;
+            do {
+                if (ip >= iend) return -1;
+                b = *ip++;
+                litLen += b;
+            } while (b == 255);
+        }
+        if (litLen > iend - ip || litLen > oend - op) return -1;
+        memcpy(op, ip, litLen);
+        ip += litLen;
+        op += litLen;
+        if (ip == iend) break;  // Dernière séquence
+
+        if (iend - ip < 2) return -1;
+        int offset = ip[0] | (ip[1] << 8);
+        ip += 2;
+        if (offset == 0 || offset > op - (unsigned char*)dst) return -1;
+
+        int matchLen = token & 15;
+        if (matchLen == 15) {
+            int b;
+            do {
+                if (ip >= iend) return -1;
+                b = *ip++;
+                matchLen += b;
+            } while (b == 255);
+        }
+        matchLen += LZ_MIN_MATCH;
+        if (matchLen > oend - op) return -1;
+
+        // Copie octet par octet : la source peut chevaucher la destination
+        const unsigned char* match = op - offset;
+        for (int i = 0; i < matchLen; ++i) {
+            op[i] = match[i];
+        }
+        op += matchLen;
+    }
+    return (int)(op - (unsigned char*)dst);
+}
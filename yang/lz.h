@@ -0,0 +1,36 @@
+/**
+ * @file lz.h
+ * @brief Compression rapide de type LZ4 pour les fichiers compressés par morceaux.
+ */
+
+#ifndef LZ_H
+#define LZ_H
+
+/**
+ * @brief Taille maximale du résultat de lzCompress pour une entrée donnée.
+ * @param srcSize Taille des données à compresser.
+ * @return Taille de tampon suffisante pour les données compressées.
+ */
+int lzCompressBound(int srcSize);
+
+/**
+ * @brief Compresse un bloc de données (format de bloc LZ4).
+ * @param src Données à compresser.
+ * @param srcSize Taille des données à compresser.
+ * @param dst Tampon de sortie.
+ * @param dstCapacity Taille du tampon de sortie.
+ * @return Taille des données compressées, 0 si le tampon de sortie est trop petit.
+ */
+int lzCompress(const char* src, int srcSize, char* dst, int dstCapacity);
+
+/**
+ * @brief Décompresse un bloc produit par lzCompress.
+ * @param src Données compressées.
+ * @param srcSize Taille des données compressées.
+ * @param dst Tampon de sortie.
+ * @param dstCapacity Taille du tampon de sortie.
+ * @return Taille des données décompressées, -1 si les données sont invalides.
+ */
+int lzDecompress(const char* src, int srcSize, char* dst, int dstCapacity);
+
+#endif // LZ_H
@@ -4,6 +4,8 @@
  */
 
 #include "test.h"
+#include "stats.h"
+#include "trace.h"
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
@@ -27,7 +29,8 @@ void displayMenu() {
     printf("11. Changer de répertoire avec un repertoire existant par exemple tapez : /home \n");
     printf("12. Écho de message\n");
     printf("13. Visualiser l'espace disque\n");
-    printf("14. Quitter\n");
+    printf("14. Statistiques des opérations\n");
+    printf("15. Quitter\n");
     
     printf("Sélectionnez une option : ");
 }
@@ -42,6 +45,24 @@ int main() {
     char choice[3];
     file* f = NULL;
 
+    initializePartitionStatus();
+
+    // STATS=1 mesure les opérations ; STATS_DUMP_FILE les écrit aussi périodiquement dans un fichier
+    const char* dumpPath = getenv("STATS_DUMP_FILE");
+    if (getenv("STATS") || dumpPath) {
+        setStatsEnabled(1);
+    }
+    if (dumpPath) {
+        const char* interval = getenv("STATS_DUMP_INTERVAL");
+        startStatsDump(dumpPath, interval ? atoi(interval) : 10);
+    }
+
+    // TRACE_FILE enregistre tous les appels pour les rejouer ensuite (programme replay)
+    const char* tracePath = getenv("TRACE_FILE");
+    if (tracePath) {
+        startTrace(tracePath);
+    }
+
     while (running) {
         displayMenu();
         fgets(choice, sizeof(choice), stdin);
@@ -65,7 +86,7 @@ int main() {
             case 2:
                 if (f != NULL) {
                     printf("Fermeture du fichier précédemment ouvert.\n");
-                    free(f); // S'assurer que tout fichier précédemment ouvert est fermé
+                    myClose(f); // S'assurer que tout fichier précédemment ouvert est fermé
                     f = NULL;
                 }
                 printf("Entrez le nom du fichier à ouvrir : ");
@@ -229,14 +250,22 @@ int main() {
             case 13: // Visualiser l'espace disque
                 visualizePartitionStatus(&g_partitionStatus);
                 break;
-            case 14: // Quitter
+            case 14: { // Statistiques des opérations
+                if (!g_statsEnabled) {
+                    printf("Statistiques désactivées (relancer avec STATS=1).\n");
+                    break;
+                }
+                Stats stats;
+                myStats(&stats);
+                printStats(stdout, &stats);
+                break;
+            }
+            case 15: // Quitter
                 printf("Fermeture...\n");
                 running = 0;
-                if (f != NULL) {
-                    if (f->data != NULL) free(f->data);
-                    if (f->name != NULL) free(f->name);
-                    free(f);
-                }
+                myClose(f);  // Avant l'arrêt de la trace, qui enregistre la fermeture
+                stopStatsDump();
+                stopTrace();
                 exit(0); // Quitter le programme directement
                 break;
             default:
@@ -244,11 +273,7 @@ int main() {
         }
     }
     // Assurez-vous de libérer toutes les ressources avant de quitter
-    if (f != NULL) {
-        if (f->data != NULL) free(f->data);
-        if (f->name != NULL) free(f->name);
-        free(f);
-    }
+    myClose(f);
 
     return 0;
 }
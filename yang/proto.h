@@ -0,0 +1,79 @@
+/**
+ * @file proto.h
+ * @brief Protocole binaire entre le serveur de partition et ses clients.
+ *
+ * Chaque requête est un en-tête ProtoRequest suivi de `length` octets de
+ * données ; chaque réponse est un en-tête ProtoResponse suivi de `length`
+ * octets. Les réponses arrivent dans l'ordre des requêtes, qui peuvent être
+ * envoyées à la suite sans attendre (pipeline).
+ *
+ * Une lecture ou une écriture découpée en plusieurs requêtes donne à chacune
+ * la position où elle doit commencer (arg1) : si un morceau échoue ou reste
+ * incomplet, les morceaux suivants, déjà envoyés, sont refusés au lieu
+ * d'être exécutés à la mauvaise position.
+ *
+ * Les données de plus de PROTO_INLINE_MAX octets passent par une mémoire
+ * partagée (memfd) que le client transmet au serveur avec PROTO_ATTACH :
+ * avec le drapeau PROTO_SHM, elles sont à shm_offset dans cette mémoire et
+ * rien ne suit l'en-tête. Les entiers sont dans l'ordre de la machine :
+ * client et serveur sont sur le même hôte.
+ */
+
+#ifndef PROTO_H
+#define PROTO_H
+
+#include <stdint.h>
+
+#define PROTO_INLINE_MAX (64 * 1024) /**< Données transmises dans la socket au-delà desquelles on passe par la mémoire partagée */
+#define PROTO_SHM_SIZE (4 * 1024 * 1024) /**< Taille de la mémoire partagée d'une connexion */
+#define PROTO_NAME_MAX 4096 /**< Longueur maximale d'un nom de fichier */
+
+#define PROTO_SHM 0x01 /**< Drapeau : les données (écrites ou lues) sont dans la mémoire partagée à shm_offset */
+
+/**
+ * @brief Opérations du protocole.
+ */
+typedef enum {
+    PROTO_ATTACH = 1, /**< Transmet la mémoire partagée (descripteur joint au message) */
+    PROTO_FORMAT,     /**< Données : nom de la partition */
+    PROTO_OPEN,       /**< Données : nom du fichier (créé s'il n'existe pas) ; résultat : descripteur */
+    PROTO_CLOSE,      /**< Libère le descripteur sans supprimer le fichier */
+    PROTO_WRITE,      /**< Données : octets à écrire à la position courante ; arg1 : voir PROTO_READ */
+    PROTO_READ,       /**< arg0 : octets à lire ; arg1 : 0, ou position attendue + 1 (sinon échec sans rien faire) ; réponse : octets lus */
+    PROTO_SEEK,       /**< arg0 : décalage, arg1 : origine ; résultat : nouvelle position */
+    PROTO_SIZE,       /**< Résultat : taille du fichier */
+    PROTO_DELETE,     /**< Supprime le fichier et libère le descripteur */
+    PROTO_COPY,       /**< Données : source et destination séparées par un zéro */
+    PROTO_RENAME,     /**< Données : ancien et nouveau nom séparés par un zéro */
+    PROTO_MOVE        /**< Données : source et destination séparées par un zéro */
+} ProtoOp;
+
+/**
+ * @brief En-tête d'une requête (40 octets).
+ */
+typedef struct {
+    uint32_t length; /**< Octets de données de la requête */
+    uint32_t id; /**< Numéro de la requête, renvoyé dans la réponse */
+    uint8_t op; /**< Opération (ProtoOp) */
+    uint8_t flags; /**< PROTO_SHM */
+    uint16_t reserved; /**< À zéro */
+    int32_t handle; /**< Descripteur de fichier renvoyé par PROTO_OPEN */
+    uint32_t shm_offset; /**< Position des données (ou de la zone de lecture) dans la mémoire partagée */
+    uint32_t reserved2; /**< À zéro */
+    int64_t arg0; /**< Premier argument */
+    int64_t arg1; /**< Second argument */
+} ProtoRequest;
+
+/**
+ * @brief En-tête d'une réponse (24 octets).
+ */
+typedef struct {
+    uint32_t length; /**< Octets de données de la réponse */
+    uint32_t id; /**< Numéro de la requête */
+    int64_t result; /**< Valeur de retour, -1 en cas d'échec */
+    uint8_t flags; /**< PROTO_SHM si les données lues sont dans la mémoire partagée */
+    uint8_t reserved[3]; /**< À zéro */
+    uint32_t shm_offset; /**< Position des données dans la mémoire partagée */
+} ProtoResponse;
+
+#endif // PROTO_H
@@ -0,0 +1,440 @@
+/**
+ * @file replay.c
+ * @brief Relecture d'une trace d'appels (cible make replay).
+ *
+ * Usage : replay [-p] [-t fils] [-C répertoire] trace
+ *
+ * La trace est chargée en mémoire puis rejouée dans le répertoire courant
+ * (ou celui passé par -C), au plus vite ou, avec -p, au rythme d'origine.
+ * Les fils enregistrés sont répartis sur les fils de relecture en gardant
+ * l'ordre de chacun ; les appels sur un fichier ouvert suivent toutefois le
+ * fil de relecture qui l'a ouvert, pour ne jamais être rejoués avant son
+ * ouverture ni dans le désordre. La bibliothèque n'étant pas réentrante, les appels
+ * eux-mêmes restent sérialisés par un verrou. Le contenu des écritures
+ * n'est pas enregistré : il est remplacé par des octets pseudo-aléatoires.
+ */
+
+#include "test.h"
+#include "stats.h"
+#include "trace.h"
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#define REPLAY_MAX_THREADS 64 /**< Nombre maximal de fils de relecture */
+
+/**
+ * @brief Appel chargé depuis la trace.
+ */
+typedef struct {
+    TraceRecord record; /**< Enregistrement */
+    char* name0; /**< Premier nom, NULL si aucun */
+    char* name1; /**< Second nom, NULL si aucun */
+    int worker; /**< Fil de relecture qui rejoue l'appel */
+} ReplayOp;
+
+/**
+ * @brief Compteurs d'un fil de relecture.
+ */
+typedef struct {
+    int index; /**< Numéro du fil de relecture */
+    long long replayed; /**< Appels rejoués */
+    long long skipped; /**< Appels ignorés (fichier inconnu, ouverture échouée) */
+    long long repositioned; /**< Positions recalées sur celle de la trace */
+    char* buffer; /**< Tampon des lectures et écritures */
+    int bufferSize; /**< Taille du tampon */
+} ReplayWorker;
+
+static ReplayOp* g_ops = NULL; /**< Appels de la trace */
+static int g_opCount = 0; /**< Nombre d'appels */
+static file** g_handles = NULL; /**< Fichiers ouverts, indexés par identifiant renuméroté */
+static int g_handleCount = 0; /**< Taille de g_handles */
+static int g_threads = 1; /**< Nombre de fils de relecture */
+static int g_paced = 0; /**< 1 pour respecter le rythme d'origine */
+static long long g_replayStart = 0; /**< Début de la relecture */
+static pthread_mutex_t g_libraryLock = PTHREAD_MUTEX_INITIALIZER; /**< Sérialise les appels */
+
+/**
+ * @brief Copie un nom lu dans la trace, NULL s'il est vide.
+ */
+static char* copyName(const char* name) {
+    if (name[0] == '\0') {
+        return NULL;
+    }
+    char* copy = strdup(name);
+    if (!copy) {
+        perror("Échec de l'allocation d'un nom");
+        exit(1);
+    }
+    return copy;
+}
+
+/**
+ * @brief Comparaison d'identifiants pour qsort et bsearch.
+ */
+static int compareHandles(const void* a, const void* b) {
+    int32_t x = *(const int32_t*)a;
+    int32_t y = *(const int32_t*)b;
+    return (x > y) - (x < y);
+}
+
+/**
+ * @brief Renumérote les identifiants de fichiers de 1 au nombre d'ouvertures.
+ *
+ * Les identifiants lus dans la trace ne sont pas bornés : g_handles est
+ * dimensionnée par le nombre d'ouvertures enregistrées, et les appels sur
+ * un identifiant qu'aucune ouverture n'a attribué reçoivent 0 (ignorés).
+ */
+static void renumberHandles(void) {
+    int32_t* opened = (int32_t*)malloc((g_opCount + 1) * sizeof(int32_t));
+    if (!opened) {
+        perror("Échec de l'allocation des identifiants");
+        exit(1);
+    }
+    int count = 0;
+    for (int i = 0; i < g_opCount; ++i) {
+        const TraceRecord* r = &g_ops[i].record;
+        if (r->op == OP_OPEN && r->handle > 0) {
+            opened[count++] = r->handle;
+        }
+    }
+    qsort(opened, count, sizeof(int32_t), compareHandles);
+    int unique = 0;
+    for (int i = 0; i < count; ++i) {
+        if (unique == 0 || opened[unique - 1] != opened[i]) {
+            opened[unique++] = opened[i];
+        }
+    }
+    for (int i = 0; i < g_opCount; ++i) {
+        TraceRecord* r = &g_ops[i].record;
+        int32_t* found = r->handle > 0 ? (int32_t*)bsearch(&r->handle, opened, unique, sizeof(int32_t),
+                                                           compareHandles) : NULL;
+        r->handle = found ? (int32_t)(found - opened) + 1 : 0;
+    }
+    free(opened);
+    g_handleCount = unique + 1;
+}
+
+/**
+ * @brief Charge toute la trace en mémoire.
+ */
+static int loadTrace(const char* path) {
+    FILE* fp = openTrace(path);
+    if (!fp) {
+        return -1;
+    }
+    static char name0[TRACE_NAME_MAX + 1];
+    static char name1[TRACE_NAME_MAX + 1];
+    int capacity = 0;
+    int status;
+    TraceRecord record;
+    while ((status = readTraceRecord(fp, &record, name0, name1)) == 1) {
+        if (g_opCount == capacity) {
+            capacity = capacity ? 2 * capacity : 4096;
+            g_ops = (ReplayOp*)realloc(g_ops, capacity * sizeof(ReplayOp));
+            if (!g_ops) {
+                perror("Échec de l'allocation de la trace");
+                exit(1);
+            }
+        }
+        g_ops[g_opCount].record = record;
+        g_ops[g_opCount].name0 = copyName(name0);
+        g_ops[g_opCount].name1 = copyName(name1);
+        ++g_opCount;
+    }
+    fclose(fp);
+    if (status == -1) {
+        fprintf(stderr, "Trace tronquée ou invalide après %d appels : %s\n", g_opCount, path);
+        return -1;
+    }
+
+    renumberHandles();
+    g_handles = (file**)calloc(g_handleCount, sizeof(file*));
+    if (!g_handles) {
+        perror("Échec de l'allocation des fichiers");
+        exit(1);
+    }
+    return 0;
+}
+
+/**
+ * @brief Agrandit le tampon du fil et le remplit d'octets pseudo-aléatoires.
+ */
+static char* workerBuffer(ReplayWorker* w, int size) {
+    if (size > w->bufferSize) {
+        w->buffer = (char*)realloc(w->buffer, size);
+        if (!w->buffer) {
+            perror("Échec de l'allocation du tampon");
+            exit(1);
+        }
+        unsigned int seed = (unsigned int)(w->index + 1);
+        for (int i = w->bufferSize; i < size; ++i) {
+            w->buffer[i] = (char)rand_r(&seed);
+        }
+        w->bufferSize = size;
+    }
+    return w->buffer;
+}
+
+/**
+ * @brief Fichier correspondant à l'identifiant d'un appel, NULL s'il n'est pas ouvert.
+ */
+static file* handleFile(const TraceRecord* r) {
+    return r->handle > 0 && r->handle < g_handleCount ? g_handles[r->handle] : NULL;
+}
+
+/**
+ * @brief Rejoue un appel (verrou de la bibliothèque tenu).
+ * @return 1 si l'appel a été rejoué, 0 s'il a été ignoré.
+ */
+static int replayOne(ReplayWorker* w, const ReplayOp* op) {
+    const TraceRecord* r = &op->record;
+    file* f = handleFile(r);
+
+    switch (r->op) {
+        case OP_FORMAT:
+            myFormat(op->name0);
+            return 1;
+        case OP_OPEN: {
+            if (r->failed || !op->name0 || r->handle <= 0) {
+                return 0;
+            }
+            // Créer le fichier d'avance : myOpen demanderait confirmation
+            FILE* fp = fopen(op->name0, "ab");
+            if (fp) {
+                fclose(fp);
+            }
+            g_handles[r->handle] = myOpen(op->name0);
+            return 1;
+        }
+        case OP_WRITE:
+        case OP_READ: {
+            if (!f || r->arg1 < 1) {
+                return 0;
+            }
+            if (f->current_position != r->arg0) {
+                f->current_position = (int)r->arg0;  // Recaler sur la trace
+                ++w->repositioned;
+            }
+            char* buffer = workerBuffer(w, (int)r->arg1);
+            if (r->op == OP_WRITE) {
+                myWrite(f, buffer, (int)r->arg1);
+            } else {
+                myRead(f, buffer, (int)r->arg1);
+            }
+            return 1;
+        }
+        case OP_SEEK:
+            if (!f) {
+                return 0;
+            }
+            mySeek(f, (int)r->arg0, (int)r->arg1);
+            return 1;
+        case OP_SIZE:
+            if (!f) {
+                return 0;
+            }
+            getFileSize(f);
+            return 1;
+        case OP_DELETE:
+            if (!f) {
+                return 0;
+            }
+            myDelete(f);
+            g_handles[r->handle] = NULL;
+            return 1;
+        case OP_CLOSE:
+            if (!f) {
+                return 0;
+            }
+            myClose(f);
+            g_handles[r->handle] = NULL;
+            return 1;
+        case OP_COPY:
+        case OP_RENAME:
+        case OP_MOVE:
+            if (!op->name0 || !op->name1) {
+                return 0;
+            }
+            if (r->op == OP_COPY) {
+                myCopy(op->name0, op->name1);
+            } else if (r->op == OP_RENAME) {
+                myRename(op->name0, op->name1);
+            } else {
+                myMove(op->name0, op->name1);
+            }
+            return 1;
+        default:
+            return 0;  // Opérations sur les blocs : jamais tracées
+    }
+}
+
+/**
+ * @brief Attend l'instant d'origine d'un appel (relecture au rythme de la trace).
+ */
+static void waitForRecord(const TraceRecord* r) {
+    long long target = g_replayStart + (long long)(r->time_ns - g_ops[0].record.time_ns);
+    struct timespec ts = { target / 1000000000LL, target % 1000000000LL };
+    while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &ts, NULL) != 0) {
+    }
+}
+
+/**
+ * @brief Fil de relecture : rejoue dans l'ordre les appels qui lui reviennent.
+ */
+static void* replayThread(void* arg) {
+    ReplayWorker* w = (ReplayWorker*)arg;
+    for (int i = 0; i < g_opCount; ++i) {
+        const ReplayOp* op = &g_ops[i];
+        if (op->worker != w->index) {
+            continue;
+        }
+        if (g_paced) {
+            waitForRecord(&op->record);
+        }
+        pthread_mutex_lock(&g_libraryLock);
+        int replayed = replayOne(w, op);
+        pthread_mutex_unlock(&g_libraryLock);
+        if (replayed) {
+            ++w->replayed;
+        } else {
+            ++w->skipped;
+        }
+    }
+    return NULL;
+}
+
+/**
+ * @brief Choisit le fil de relecture de chaque appel.
+ *
+ * Une ouverture revient au fil de relecture de son fil enregistré ; les
+ * appels sur le fichier ouvert reviennent au même fil de relecture, quel
+ * que soit le fil qui les a faits. Les autres appels suivent leur fil
+ * enregistré.
+ */
+static void assignWorkers(void) {
+    int* owner = (int*)malloc(g_handleCount * sizeof(int));
+    if (!owner) {
+        perror("Échec de l'allocation des fils de relecture");
+        exit(1);
+    }
+    for (int i = 0; i < g_handleCount; ++i) {
+        owner[i] = -1;
+    }
+    for (int i = 0; i < g_opCount; ++i) {
+        ReplayOp* op = &g_ops[i];
+        int handle = op->record.handle;
+        op->worker = (int)(op->record.thread % g_threads);
+        if (handle <= 0 || handle >= g_handleCount) {
+            continue;
+        }
+        if (owner[handle] == -1 && op->record.op == OP_OPEN) {
+            owner[handle] = op->worker;
+        }
+        if (owner[handle] != -1) {
+            op->worker = owner[handle];
+        }
+    }
+    free(owner);
+}
+
+/**
+ * @brief Affiche l'usage du programme.
+ */
+static void usage(const char* program) {
+    fprintf(stderr, "Usage : %s [-p] [-t fils] [-C répertoire] trace\n"
+                    "  -p  respecter le rythme d'origine (par défaut : au plus vite)\n"
+                    "  -t  nombre de fils de relecture (par défaut : 1)\n"
+                    "  -C  répertoire dans lequel rejouer la trace\n", program);
+}
+
+int main(int argc, char** argv) {
+    const char* dir = NULL;
+    int opt;
+    while ((opt = getopt(argc, argv, "pt:C:")) != -1) {
+        switch (opt) {
+            case 'p':
+                g_paced = 1;
+                break;
+            case 't':
+                g_threads = atoi(optarg);
+                break;
+            case 'C':
+                dir = optarg;
+                break;
+            default:
+                usage(argv[0]);
+                return 1;
+        }
+    }
+    if (optind != argc - 1 || g_threads < 1 || g_threads > REPLAY_MAX_THREADS) {
+        usage(argv[0]);
+        return 1;
+    }
+    if (loadTrace(argv[optind]) == -1) {
+        return 1;
+    }
+    assignWorkers();
+    if (dir && chdir(dir) != 0) {
+        perror("Échec du changement de répertoire");
+        return 1;
+    }
+
+    // Garder la vraie sortie standard pour le résumé, faire taire la bibliothèque
+    FILE* out = fdopen(dup(STDOUT_FILENO), "w");
+    if (!out || !freopen("/dev/null", "w", stdout)) {
+        perror("Échec de la préparation de la sortie");
+        return 1;
+    }
+
+    initializePartitionStatus();
+    setStatsEnabled(1);
+
+    ReplayWorker workers[REPLAY_MAX_THREADS];
+    pthread_t threads[REPLAY_MAX_THREADS];
+    memset(workers, 0, sizeof(workers));
+    g_replayStart = statsNow();
+    for (int i = 0; i < g_threads; ++i) {
+        workers[i].index = i;
+        if (pthread_create(&threads[i], NULL, replayThread, &workers[i]) != 0) {
+            perror("Échec du lancement d'un fil de relecture");
+            return 1;
+        }
+    }
+
+    long long replayed = 0, skipped = 0, repositioned = 0;
+    for (int i = 0; i < g_threads; ++i) {
+        pthread_join(threads[i], NULL);
+        replayed += workers[i].replayed;
+        skipped += workers[i].skipped;
+        repositioned += workers[i].repositioned;
+        free(workers[i].buffer);
+    }
+    double seconds = (statsNow() - g_replayStart) / 1e9;
+
+    fprintf(out, "Appels rejoués : %lld, ignorés : %lld, positions recalées : %lld\n",
+            replayed, skipped, repositioned);
+    fprintf(out, "Durée : %.3f s (%.0f appels/s, %s, %d fil%s)\n", seconds,
+            seconds > 0 ? replayed / seconds : 0.0, g_paced ? "rythme d'origine" : "au plus vite",
+            g_threads, g_threads > 1 ? "s" : "");
+    Stats stats;
+    myStats(&stats);
+    printStats(out, &stats);
+    fclose(out);
+
+    // Les fichiers restés ouverts ne sont pas supprimés, seulement libérés
+    for (int i = 0; i < g_handleCount; ++i) {
+        myClose(g_handles[i]);
+    }
+    flushDiscards();
+    for (int i = 0; i < g_opCount; ++i) {
+        free(g_ops[i].name0);
+        free(g_ops[i].name1);
+    }
+    free(g_ops);
+    free(g_handles);
+    return 0;
+}
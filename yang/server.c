@@ -0,0 +1,690 @@
+/**
+ * @file server.c
+ * @brief Serveur de partition sur socket Unix (cible make server).
+ *
+ * Usage : server socket
+ *
+ * Le serveur possède la partition et les fichiers ouverts ; plusieurs
+ * processus y accèdent par la bibliothèque cliente (client.h). Une seule
+ * boucle epoll sert toutes les connexions : chaque lecture peut apporter
+ * plusieurs requêtes, exécutées dans l'ordre, dont les réponses sont
+ * regroupées en un seul envoi. La bibliothèque n'est donc jamais appelée
+ * par deux fils à la fois. Un fichier ouvert par plusieurs connexions est
+ * partagé : toutes voient les mêmes données, chaque descripteur gardant
+ * sa propre position. SIGINT ou SIGTERM arrêtent le serveur, qui
+ * affiche alors les statistiques des opérations.
+ */
+
+#define _GNU_SOURCE // pour MSG_CMSG_CLOEXEC
+#include "proto.h"
+#include "stats.h"
+#include "test.h"
+#include <errno.h>
+#include <fcntl.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/epoll.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#define SERVER_MAX_EVENTS 64 /**< Événements traités par appel à epoll_wait */
+#define SERVER_READ_CHUNK (128 * 1024) /**< Place libre garantie avant chaque lecture */
+#define SERVER_MAX_REQUEST (PROTO_INLINE_MAX + sizeof(ProtoRequest)) /**< Taille maximale d'une requête dans la socket */
+#define SERVER_MAX_INPUT (4 * SERVER_READ_CHUNK) /**< Octets reçus gardés au plus par connexion */
+#define SERVER_MAX_OUTPUT (1024 * 1024) /**< Réponses en attente au-delà desquelles on cesse d'exécuter */
+
+/**
+ * @brief Fichier ouvert, partagé par tous les descripteurs qui le désignent.
+ */
+typedef struct SharedFile {
+    file* f; /**< Fichier ouvert, NULL une fois supprimé */
+    int refs; /**< Descripteurs qui le désignent */
+    struct SharedFile* next; /**< Fichier ouvert suivant */
+} SharedFile;
+
+/**
+ * @brief Descripteur de fichier d'une connexion.
+ */
+typedef struct {
+    SharedFile* shared; /**< Fichier désigné, NULL si la case est libre */
+    int position; /**< Position courante propre au descripteur */
+} Handle;
+
+/**
+ * @brief État d'une connexion cliente.
+ */
+typedef struct {
+    int fd; /**< Socket de la connexion */
+    char* in; /**< Octets reçus, pas encore traités */
+    size_t inLength; /**< Octets valides dans in */
+    size_t inCapacity; /**< Taille de in */
+    char* out; /**< Réponses pas encore envoyées */
+    size_t outLength; /**< Octets valides dans out */
+    size_t outSent; /**< Octets de out déjà envoyés */
+    size_t outCapacity; /**< Taille de out */
+    int waitingOutput; /**< 1 si EPOLLOUT est surveillé à la place de EPOLLIN */
+    int pendingFd; /**< Descripteur reçu en attente de PROTO_ATTACH, -1 si aucun */
+    char* shm; /**< Mémoire partagée du client, NULL si aucune */
+    Handle* handles; /**< Fichiers ouverts, indexés par descripteur */
+    int handleCount; /**< Taille de handles */
+} Connection;
+
+static volatile sig_atomic_t g_stop = 0; /**< Arrêt demandé par un signal */
+static int g_epoll = -1; /**< Instance epoll */
+static SharedFile* g_sharedFiles = NULL; /**< Fichiers ouverts par au moins une connexion */
+
+/**
+ * @brief Gestionnaire de SIGINT et SIGTERM.
+ */
+static void onSignal(int sig) {
+    (void)sig;
+    g_stop = 1;
+}
+
+/**
+ * @brief Agrandit un tampon pour qu'il puisse contenir `needed` octets.
+ * @return 0 en cas de succès, -1 en cas d'échec d'allocation.
+ */
+static int reserve(char** buffer, size_t* capacity, size_t needed) {
+    if (needed <= *capacity) {
+        return 0;
+    }
+    size_t size = *capacity ? *capacity : SERVER_READ_CHUNK;
+    while (size < needed) {
+        size *= 2;
+    }
+    char* grown = (char*)realloc(*buffer, size);
+    if (!grown) {
+        perror("Échec de l'allocation d'un tampon de connexion");
+        return -1;
+    }
+    *buffer = grown;
+    *capacity = size;
+    return 0;
+}
+
+/**
+ * @brief Ouvre un fichier, ou reprend celui qu'une autre connexion a déjà ouvert.
+ * @return Le fichier partagé, NULL en cas d'échec.
+ */
+static SharedFile* openShared(char* name) {
+    for (SharedFile* s = g_sharedFiles; s; s = s->next) {
+        if (s->f && strcmp(s->f->name, name) == 0) {
+            ++s->refs;
+            return s;
+        }
+    }
+    // Créer le fichier d'avance : myOpen demanderait confirmation sur l'entrée standard
+    FILE* fp = fopen(name, "ab");
+    if (fp) {
+        fclose(fp);
+    }
+    SharedFile* s = (SharedFile*)malloc(sizeof(SharedFile));
+    if (!s) {
+        return NULL;
+    }
+    s->f = myOpen(name);
+    if (!s->f) {
+        free(s);
+        return NULL;
+    }
+    s->refs = 1;
+    s->next = g_sharedFiles;
+    g_sharedFiles = s;
+    return s;
+}
+
+/**
+ * @brief Libère un descripteur ; le fichier est fermé avec le dernier.
+ */
+static void releaseHandle(Handle* h) {
+    SharedFile* s = h->shared;
+    h->shared = NULL;
+    if (!s || --s->refs > 0) {
+        return;
+    }
+    SharedFile** link = &g_sharedFiles;
+    while (*link != s) {
+        link = &(*link)->next;
+    }
+    *link = s->next;
+    myClose(s->f);
+    free(s);
+}
+
+/**
+ * @brief Ferme une connexion et libère tout ce qu'elle possède.
+ */
+static void closeConnection(Connection* c) {
+    for (int i = 0; i < c->handleCount; ++i) {
+        releaseHandle(&c->handles[i]);
+    }
+    if (c->shm) {
+        munmap(c->shm, PROTO_SHM_SIZE);
+    }
+    if (c->pendingFd >= 0) {
+        close(c->pendingFd);
+    }
+    close(c->fd);  // Retire aussi la socket de l'instance epoll
+    free(c->handles);
+    free(c->in);
+    free(c->out);
+    free(c);
+}
+
+/**
+ * @brief Descripteur ouvert correspondant à un numéro, NULL s'il n'est pas ouvert.
+ */
+static Handle* findHandle(Connection* c, int handle) {
+    return handle >= 0 && handle < c->handleCount && c->handles[handle].shared ? &c->handles[handle] : NULL;
+}
+
+/**
+ * @brief Range un fichier ouvert dans la première case libre.
+ * @return Le descripteur attribué, -1 en cas d'échec.
+ */
+static int addHandle(Connection* c, SharedFile* s) {
+    int handle = 0;
+    while (handle < c->handleCount && c->handles[handle].shared) {
+        ++handle;
+    }
+    if (handle == c->handleCount) {
+        int count = c->handleCount ? 2 * c->handleCount : 16;
+        Handle* grown = (Handle*)realloc(c->handles, count * sizeof(Handle));
+        if (!grown) {
+            return -1;
+        }
+        memset(grown + c->handleCount, 0, (count - c->handleCount) * sizeof(Handle));
+        c->handles = grown;
+        c->handleCount = count;
+    }
+    c->handles[handle].shared = s;
+    c->handles[handle].position = 0;
+    return handle;
+}
+
+/**
+ * @brief Sépare les données d'une requête en un ou deux noms terminés par un zéro.
+ * @return 0 si les noms sont valides, -1 sinon.
+ */
+static int parseNames(const char* data, uint32_t length, char* name0, char* name1) {
+    if (length == 0 || length > 2 * (PROTO_NAME_MAX + 1)) {
+        return -1;
+    }
+    size_t len0 = strnlen(data, length);
+    if (len0 == 0 || len0 > PROTO_NAME_MAX) {
+        return -1;
+    }
+    memcpy(name0, data, len0);
+    name0[len0] = '\0';
+    if (!name1) {
+        return 0;
+    }
+    if (len0 + 1 >= length) {
+        return -1;
+    }
+    size_t len1 = strnlen(data + len0 + 1, length - len0 - 1);
+    if (len1 == 0 || len1 > PROTO_NAME_MAX) {
+        return -1;
+    }
+    memcpy(name1, data + len0 + 1, len1);
+    name1[len1] = '\0';
+    return 0;
+}
+
+/**
+ * @brief Attache la mémoire partagée reçue avec la requête.
+ */
+static int attachSharedMemory(Connection* c) {
+    struct stat st;
+    if (c->shm || c->pendingFd < 0 || fstat(c->pendingFd, &st) != 0 || st.st_size < PROTO_SHM_SIZE) {
+        return -1;
+    }
+    void* shm = mmap(NULL, PROTO_SHM_SIZE, PROT_READ | PROT_WRITE, MAP_SHARED, c->pendingFd, 0);
+    close(c->pendingFd);
+    c->pendingFd = -1;
+    if (shm == MAP_FAILED) {
+        perror("Échec de l'attachement de la mémoire partagée");
+        return -1;
+    }
+    c->shm = (char*)shm;
+    return 0;
+}
+
+/**
+ * @brief Exécute une requête et ajoute sa réponse au tampon de sortie.
+ * @param data Données de la requête (dans la socket ou la mémoire partagée).
+ * @return 0 en cas de succès, -1 si la connexion doit être fermée.
+ */
+static int execute(Connection* c, const ProtoRequest* req, const char* data) {
+    static char name0[PROTO_NAME_MAX + 1];
+    static char name1[PROTO_NAME_MAX + 1];
+
+    // Réserver la réponse ; une lecture sans mémoire partagée y écrit ses données
+    size_t readLength = req->op == PROTO_READ && !(req->flags & PROTO_SHM) && req->arg0 > 0 ? req->arg0 : 0;
+    if (reserve(&c->out, &c->outCapacity, c->outLength + sizeof(ProtoResponse) + readLength) == -1) {
+        return -1;
+    }
+    ProtoResponse resp;
+    memset(&resp, 0, sizeof(resp));
+    resp.id = req->id;
+    resp.result = -1;
+    char* payload = c->out + c->outLength + sizeof(ProtoResponse);
+
+    // Le fichier est partagé : y charger la position propre à ce descripteur
+    Handle* h = findHandle(c, req->handle);
+    file* f = h ? h->shared->f : NULL;
+    if (f) {
+        f->current_position = h->position;
+    }
+    // Morceau d'un transfert découpé : refusé si les précédents ne sont pas allés jusqu'au bout
+    int inPlace = req->arg1 == 0 || (f && req->arg1 - 1 == f->current_position);
+    switch (req->op) {
+        case PROTO_ATTACH:
+            resp.result = attachSharedMemory(c);
+            break;
+        case PROTO_FORMAT:
+            if (parseNames(data, req->length, name0, NULL) == 0) {
+                resp.result = myFormat(name0);
+            }
+            break;
+        case PROTO_OPEN:
+            if (parseNames(data, req->length, name0, NULL) == 0) {
+                SharedFile* opened = openShared(name0);
+                if (opened) {
+                    resp.result = addHandle(c, opened);
+                    if (resp.result == -1) {
+                        Handle orphan = { opened, 0 };
+                        releaseHandle(&orphan);
+                    }
+                }
+            }
+            break;
+        case PROTO_CLOSE:
+            if (h) {
+                releaseHandle(h);  // Un descripteur sur un fichier supprimé se ferme aussi
+                h = NULL;
+                resp.result = 0;
+            }
+            break;
+        case PROTO_WRITE:
+            if (f && inPlace) {
+                resp.result = myWrite(f, (void*)data, (int)req->length);
+            }
+            break;
+        case PROTO_READ:
+            if (f && inPlace && req->arg0 > 0) {
+                if (req->flags & PROTO_SHM) {
+                    resp.result = myRead(f, c->shm + req->shm_offset, (int)req->arg0);
+                    resp.flags = PROTO_SHM;
+                    resp.shm_offset = req->shm_offset;
+                } else {
+                    resp.result = myRead(f, payload, (int)req->arg0);
+                }
+                resp.length = resp.result > 0 ? (uint32_t)resp.result : 0;
+            }
+            break;
+        case PROTO_SEEK:
+            if (f) {
+                mySeek(f, (int)req->arg0, (int)req->arg1);
+                resp.result = f->current_position;
+            }
+            break;
+        case PROTO_SIZE:
+            if (f) {
+                resp.result = getFileSize(f);
+            }
+            break;
+        case PROTO_DELETE:
+            if (f) {
+                // Les autres descripteurs du fichier échouent désormais
+                myDelete(f);
+                h->shared->f = NULL;
+                releaseHandle(h);
+                h = NULL;
+                resp.result = 0;
+            }
+            break;
+        case PROTO_COPY:
+        case PROTO_RENAME:
+        case PROTO_MOVE:
+            if (parseNames(data, req->length, name0, name1) == 0) {
+                if (req->op == PROTO_COPY) {
+                    resp.result = myCopy(name0, name1);
+                } else if (req->op == PROTO_RENAME) {
+                    resp.result = myRename(name0, name1);
+                } else {
+                    resp.result = myMove(name0, name1);
+                }
+            }
+            break;
+        default:
+            return -1;  // Opération inconnue : client incompatible
+    }
+    if (h && h->shared->f) {
+        h->position = h->shared->f->current_position;
+    }
+
+    memcpy(c->out + c->outLength, &resp, sizeof(resp));
+    c->outLength += sizeof(resp) + (resp.flags & PROTO_SHM ? 0 : resp.length);
+    return 0;
+}
+
+/**
+ * @brief Exécute les requêtes complètes reçues sur la connexion.
+ *
+ * S'arrête quand SERVER_MAX_OUTPUT octets de réponses attendent d'être
+ * envoyés : les requêtes suivantes restent dans le tampon d'entrée.
+ * @return 0 si toutes ont été exécutées, 1 s'il en reste, -1 si la connexion doit être fermée.
+ */
+static int processInput(Connection* c) {
+    size_t pos = 0;
+    int more = 0;
+    while (c->inLength - pos >= sizeof(ProtoRequest)) {
+        if (c->outLength >= SERVER_MAX_OUTPUT) {
+            more = 1;
+            break;
+        }
+        ProtoRequest req;
+        memcpy(&req, c->in + pos, sizeof(req));
+        const char* data;
+        size_t consumed = sizeof(req);
+
+        if (req.flags & PROTO_SHM) {
+            uint64_t extent = (uint64_t)req.shm_offset +
+                              (req.op == PROTO_READ ? (uint64_t)(req.arg0 > 0 ? req.arg0 : 0) : req.length);
+            if (!c->shm || extent > PROTO_SHM_SIZE) {
+                return -1;
+            }
+            data = c->shm + req.shm_offset;
+        } else {
+            if (req.length > PROTO_INLINE_MAX ||
+                (req.op == PROTO_READ && req.arg0 > PROTO_INLINE_MAX)) {
+                return -1;
+            }
+            if (c->inLength - pos < sizeof(req) + req.length) {
+                break;  // Requête incomplète : attendre la suite
+            }
+            data = c->in + pos + sizeof(req);
+            consumed += req.length;
+        }
+
+        if (execute(c, &req, data) == -1) {
+            return -1;
+        }
+        pos += consumed;
+    }
+
+    memmove(c->in, c->in + pos, c->inLength - pos);
+    c->inLength -= pos;
+    return more;
+}
+
+/**
+ * @brief Surveille la possibilité d'écrire sur la connexion, ou à défaut la lecture.
+ *
+ * Tant que des réponses attendent, la connexion n'est plus lue : un client
+ * qui envoie sans lire ses réponses ne fait pas grossir les tampons.
+ */
+static void watchOutput(Connection* c, int enabled) {
+    if (c->waitingOutput == enabled) {
+        return;
+    }
+    struct epoll_event ev;
+    ev.events = enabled ? EPOLLOUT : EPOLLIN;
+    ev.data.ptr = c;
+    epoll_ctl(g_epoll, EPOLL_CTL_MOD, c->fd, &ev);
+    c->waitingOutput = enabled;
+}
+
+/**
+ * @brief Envoie autant de réponses que la socket en accepte.
+ * @return 0 en cas de succès, -1 si la connexion doit être fermée.
+ */
+static int flushOutput(Connection* c) {
+    while (c->outSent < c->outLength) {
+        ssize_t n = send(c->fd, c->out + c->outSent, c->outLength - c->outSent, MSG_NOSIGNAL);
+        if (n < 0) {
+            if (errno == EAGAIN || errno == EWOULDBLOCK) {
+                return 0;
+            }
+            if (errno == EINTR) {
+                continue;
+            }
+            return -1;
+        }
+        c->outSent += n;
+    }
+    c->outLength = 0;
+    c->outSent = 0;
+    return 0;
+}
+
+/**
+ * @brief Exécute les requêtes reçues et envoie les réponses, tant que la socket les accepte.
+ * @return 0 en cas de succès, -1 si la connexion doit être fermée.
+ */
+static int serve(Connection* c) {
+    int more;
+    do {
+        more = processInput(c);
+        if (more == -1 || flushOutput(c) == -1) {
+            return -1;
+        }
+    } while (more && c->outLength == 0);
+    watchOutput(c, c->outLength > 0);
+    return 0;
+}
+
+/**
+ * @brief Lit ce qui est disponible sur la connexion (et un éventuel descripteur joint).
+ *
+ * Au plus SERVER_MAX_INPUT octets sont gardés ; le reste attend dans la
+ * socket que les requêtes reçues aient été exécutées.
+ * @return 0 en cas de succès, -1 si la connexion doit être fermée.
+ */
+static int readInput(Connection* c) {
+    while (c->inLength < SERVER_MAX_INPUT) {
+        size_t wanted = c->inLength + SERVER_READ_CHUNK;
+        if (reserve(&c->in, &c->inCapacity, wanted < SERVER_MAX_INPUT ? wanted : SERVER_MAX_INPUT) == -1) {
+            return -1;
+        }
+        size_t limit = c->inCapacity < SERVER_MAX_INPUT ? c->inCapacity : SERVER_MAX_INPUT;
+        struct iovec iov = { c->in + c->inLength, limit - c->inLength };
+        union {
+            char buffer[CMSG_SPACE(sizeof(int))];
+            struct cmsghdr align;
+        } control;
+        struct msghdr msg;
+        memset(&msg, 0, sizeof(msg));
+        msg.msg_iov = &iov;
+        msg.msg_iovlen = 1;
+        msg.msg_control = control.buffer;
+        msg.msg_controllen = sizeof(control.buffer);
+
+        ssize_t n = recvmsg(c->fd, &msg, MSG_CMSG_CLOEXEC);
+        if (n < 0) {
+            if (errno == EAGAIN || errno == EWOULDBLOCK) {
+                return 0;
+            }
+            if (errno == EINTR) {
+                continue;
+            }
+            return -1;
+        }
+        if (n == 0) {
+            return -1;  // Le client a fermé la connexion
+        }
+        struct cmsghdr* cmsg = CMSG_FIRSTHDR(&msg);
+        if (cmsg && cmsg->cmsg_level == SOL_SOCKET && cmsg->cmsg_type == SCM_RIGHTS) {
+            int fd;
+            memcpy(&fd, CMSG_DATA(cmsg), sizeof(fd));
+            if (c->pendingFd >= 0) {
+                close(c->pendingFd);
+            }
+            c->pendingFd = fd;
+        }
+        c->inLength += n;
+    }
+    return 0;
+}
+
+/**
+ * @brief Accepte toutes les connexions en attente.
+ */
+static void acceptConnections(int listenFd) {
+    for (;;) {
+        int fd = accept4(listenFd, NULL, NULL, SOCK_NONBLOCK | SOCK_CLOEXEC);
+        if (fd < 0) {
+            if (errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR) {
+                perror("Échec de l'acceptation d'une connexion");
+            }
+            return;
+        }
+        Connection* c = (Connection*)calloc(1, sizeof(Connection));
+        if (!c) {
+            close(fd);
+            continue;
+        }
+        c->fd = fd;
+        c->pendingFd = -1;
+        struct epoll_event ev;
+        ev.events = EPOLLIN;
+        ev.data.ptr = c;
+        if (epoll_ctl(g_epoll, EPOLL_CTL_ADD, fd, &ev) != 0) {
+            perror("Échec de la surveillance d'une connexion");
+            free(c);
+            close(fd);
+        }
+    }
+}
+
+/**
+ * @brief Supprime une socket laissée à `path`, sans toucher à un autre type de fichier.
+ * @return 0 si le chemin est libre, -1 s'il est occupé par autre chose qu'une socket.
+ */
+static int removeSocket(const char* path) {
+    struct stat st;
+    if (lstat(path, &st) != 0) {
+        if (errno == ENOENT) {
+            return 0;
+        }
+        perror("Échec de l'examen du chemin de la socket");
+        return -1;
+    }
+    if (!S_ISSOCK(st.st_mode)) {
+        fprintf(stderr, "%s existe et n'est pas une socket\n", path);
+        return -1;
+    }
+    return unlink(path);
+}
+
+/**
+ * @brief Crée la socket d'écoute.
+ * @return Le descripteur de la socket, -1 en cas d'échec.
+ */
+static int listenOn(const char* path) {
+    struct sockaddr_un addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    if (strlen(path) >= sizeof(addr.sun_path)) {
+        fprintf(stderr, "Chemin de socket trop long : %s\n", path);
+        return -1;
+    }
+    strcpy(addr.sun_path, path);
+
+    int fd = socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (fd < 0) {
+        perror("Échec de la création de la socket");
+        return -1;
+    }
+    if (removeSocket(path) != 0) {  // Socket laissée par un serveur précédent
+        close(fd);
+        return -1;
+    }
+    if (bind(fd, (struct sockaddr*)&addr, sizeof(addr)) != 0 || listen(fd, SOMAXCONN) != 0) {
+        perror("Échec de l'écoute sur la socket");
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+int main(int argc, char** argv) {
+    if (argc != 2) {
+        fprintf(stderr, "Usage : %s socket\n", argv[0]);
+        return 1;
+    }
+
+    struct sigaction sa;
+    memset(&sa, 0, sizeof(sa));
+    sa.sa_handler = onSignal;  // Sans SA_RESTART : epoll_wait est interrompu
+    sigaction(SIGINT, &sa, NULL);
+    sigaction(SIGTERM, &sa, NULL);
+    signal(SIGPIPE, SIG_IGN);
+
+    int listenFd = listenOn(argv[1]);
+    g_epoll = epoll_create1(EPOLL_CLOEXEC);
+    if (listenFd < 0 || g_epoll < 0) {
+        return 1;
+    }
+    struct epoll_event ev;
+    ev.events = EPOLLIN;
+    ev.data.ptr = NULL;  // NULL désigne la socket d'écoute
+    epoll_ctl(g_epoll, EPOLL_CTL_ADD, listenFd, &ev);
+
+    // Les messages de la bibliothèque n'ont pas de destinataire ici
+    if (!freopen("/dev/null", "w", stdout)) {
+        perror("Échec de la redirection de la sortie");
+        return 1;
+    }
+    initializePartitionStatus();
+    setStatsEnabled(1);
+    fprintf(stderr, "Serveur en écoute sur %s\n", argv[1]);
+
+    struct epoll_event events[SERVER_MAX_EVENTS];
+    while (!g_stop) {
+        int n = epoll_wait(g_epoll, events, SERVER_MAX_EVENTS, -1);
+        if (n < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            perror("Échec de l'attente des connexions");
+            break;
+        }
+        for (int i = 0; i < n; ++i) {
+            Connection* c = (Connection*)events[i].data.ptr;
+            if (!c) {
+                acceptConnections(listenFd);
+                continue;
+            }
+            int alive = 1;
+            if (events[i].events & (EPOLLIN | EPOLLHUP | EPOLLERR)) {
+                // Exécuter même si le client vient de fermer : ses requêtes sont arrivées
+                alive = readInput(c) == 0;
+                if (!alive) {
+                    processInput(c);
+                }
+            }
+            if (alive && serve(c) == -1) {
+                alive = 0;
+            }
+            if (!alive) {
+                closeConnection(c);
+            }
+        }
+    }
+
+    close(listenFd);
+    removeSocket(argv[1]);
+    flushDiscards();
+    Stats stats;
+    myStats(&stats);
+    printStats(stderr, &stats);
+    return 0;
+}
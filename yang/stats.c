@@ -0,0 +1,253 @@
+/**
+ * @file stats.c
+ * @brief Implémentation des compteurs par fil et de leur fusion.
+ *
+ * Chaque fil écrit dans ses propres compteurs, sans verrou ni instruction
+ * atomique coûteuse ; les lectures (myStats) parcourent la liste des fils
+ * et additionnent leurs compteurs. Seul le fil propriétaire écrit dans ses
+ * compteurs : la remise à zéro (resetStats) en garde une copie, retranchée
+ * par les lectures suivantes.
+ */
+
+#include "stats.h"
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+/**
+ * @brief Compteurs d'un fil, chaînés pour la fusion.
+ */
+typedef struct ThreadStats {
+    Stats stats; /**< Compteurs du fil, écrits par lui seul */
+    Stats base; /**< Valeurs des compteurs à la dernière remise à zéro (protégées par g_threadsLock) */
+    struct ThreadStats* next; /**< Fil suivant */
+} ThreadStats;
+
+int g_statsEnabled = 0;
+
+static const char* kOpNames[OP_COUNT] = {
+    "myFormat", "myOpen", "myWrite", "myRead", "mySeek", "getFileSize",
+    "myDelete", "myCopy", "myRename", "myMove", "myClose", "allocateBlocks", "freeBlocks",
+};
+
+static __thread ThreadStats* t_stats = NULL; /**< Compteurs du fil courant */
+static ThreadStats* g_threads = NULL; /**< Liste des compteurs de tous les fils */
+static pthread_mutex_t g_threadsLock = PTHREAD_MUTEX_INITIALIZER; /**< Protège la liste */
+
+static pthread_t g_dumpThread; /**< Fil d'écriture périodique */
+static int g_dumpRunning = 0; /**< Écriture périodique en cours */
+static char* g_dumpPath = NULL; /**< Fichier d'écriture périodique */
+static int g_dumpInterval = 0; /**< Période en secondes */
+static pthread_mutex_t g_dumpLock = PTHREAD_MUTEX_INITIALIZER; /**< Protège l'arrêt */
+static pthread_cond_t g_dumpWake = PTHREAD_COND_INITIALIZER; /**< Réveille le fil à l'arrêt */
+
+/** Incrément relâché : le fil propriétaire est le seul à écrire. */
+#define STAT_ADD(field, value) __atomic_store_n(&(field), (field) + (value), __ATOMIC_RELAXED)
+/** Lecture relâchée d'un compteur d'un autre fil. */
+#define STAT_LOAD(field) __atomic_load_n(&(field), __ATOMIC_RELAXED)
+
+void setStatsEnabled(int enabled) {
+    g_statsEnabled = enabled != 0;
+}
+
+long long statsNow(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000000000LL + ts.tv_nsec;
+}
+
+/**
+ * @brief Compteurs du fil courant, créés et enregistrés au premier appel.
+ */
+static Stats* threadStats(void) {
+    if (!t_stats) {
+        ThreadStats* t = (ThreadStats*)calloc(1, sizeof(ThreadStats));
+        if (!t) {
+            return NULL;
+        }
+        pthread_mutex_lock(&g_threadsLock);
+        t->next = g_threads;
+        g_threads = t;
+        pthread_mutex_unlock(&g_threadsLock);
+        t_stats = t;  // Conservés à la fin du fil pour garder ses comptes
+    }
+    return &t_stats->stats;
+}
+
+void statsRecord(OpKind op, long long startNs, int failed, long long bytes) {
+    Stats* stats = threadStats();
+    if (!stats) {
+        return;
+    }
+    OpStats* s = &stats->ops[op];
+    long long ns = statsNow() - startNs;
+    if (ns < 1) {
+        ns = 1;
+    }
+    int bucket = 63 - __builtin_clzll((unsigned long long)ns);
+    if (bucket >= LATENCY_BUCKETS) {
+        bucket = LATENCY_BUCKETS - 1;
+    }
+
+    STAT_ADD(s->calls, 1);
+    STAT_ADD(s->bytes, bytes);
+    STAT_ADD(s->errors, failed != 0);
+    STAT_ADD(s->total_ns, ns);
+    STAT_ADD(s->latency[bucket], 1);
+}
+
+void statsAllocFailure(OpKind op) {
+    Stats* stats = threadStats();
+    if (stats) {
+        STAT_ADD(stats->ops[op].alloc_failures, 1);
+    }
+}
+
+void myStats(Stats* out) {
+    memset(out, 0, sizeof(*out));
+    pthread_mutex_lock(&g_threadsLock);
+    for (ThreadStats* t = g_threads; t; t = t->next) {
+        for (int op = 0; op < OP_COUNT; ++op) {
+            OpStats* from = &t->stats.ops[op];
+            OpStats* base = &t->base.ops[op];
+            OpStats* to = &out->ops[op];
+            to->calls += STAT_LOAD(from->calls) - base->calls;
+            to->bytes += STAT_LOAD(from->bytes) - base->bytes;
+            to->errors += STAT_LOAD(from->errors) - base->errors;
+            to->alloc_failures += STAT_LOAD(from->alloc_failures) - base->alloc_failures;
+            to->total_ns += STAT_LOAD(from->total_ns) - base->total_ns;
+            for (int b = 0; b < LATENCY_BUCKETS; ++b) {
+                to->latency[b] += STAT_LOAD(from->latency[b]) - base->latency[b];
+            }
+        }
+    }
+    pthread_mutex_unlock(&g_threadsLock);
+}
+
+void resetStats(void) {
+    pthread_mutex_lock(&g_threadsLock);
+    for (ThreadStats* t = g_threads; t; t = t->next) {
+        for (int op = 0; op < OP_COUNT; ++op) {
+            OpStats* from = &t->stats.ops[op];
+            OpStats* base = &t->base.ops[op];
+            base->calls = STAT_LOAD(from->calls);
+            base->bytes = STAT_LOAD(from->bytes);
+            base->errors = STAT_LOAD(from->errors);
+            base->alloc_failures = STAT_LOAD(from->alloc_failures);
+            base->total_ns = STAT_LOAD(from->total_ns);
+            for (int b = 0; b < LATENCY_BUCKETS; ++b) {
+                base->latency[b] = STAT_LOAD(from->latency[b]);
+            }
+        }
+    }
+    pthread_mutex_unlock(&g_threadsLock);
+}
+
+/**
+ * @brief Borne supérieure de la classe contenant le centile demandé.
+ */
+static uint64_t latencyPercentile(const OpStats* s, double p) {
+    uint64_t target = (uint64_t)(p * s->calls);
+    uint64_t seen = 0;
+    for (int b = 0; b < LATENCY_BUCKETS; ++b) {
+        seen += s->latency[b];
+        if (seen > target) {
+            return 2ULL << b;
+        }
+    }
+    return 2ULL << (LATENCY_BUCKETS - 1);
+}
+
+void printStats(FILE* out, const Stats* stats) {
+    fprintf(out, "%-15s %10s %12s %8s %8s %10s %10s %10s\n",
+            "opération", "appels", "octets", "erreurs", "espace", "moy (ns)", "p50 (ns)", "p99 (ns)");
+    for (int op = 0; op < OP_COUNT; ++op) {
+        const OpStats* s = &stats->ops[op];
+        if (s->calls == 0) {
+            continue;
+        }
+        fprintf(out, "%-15s %10llu %12llu %8llu %8llu %10llu %10llu %10llu\n", kOpNames[op],
+                (unsigned long long)s->calls, (unsigned long long)s->bytes,
+                (unsigned long long)s->errors, (unsigned long long)s->alloc_failures,
+                (unsigned long long)(s->total_ns / s->calls),
+                (unsigned long long)latencyPercentile(s, 0.50),
+                (unsigned long long)latencyPercentile(s, 0.99));
+    }
+}
+
+/**
+ * @brief Écrit les compteurs dans le fichier d'écriture périodique.
+ */
+static void dumpStats(void) {
+    size_t len = strlen(g_dumpPath);
+    char* tmp = (char*)malloc(len + 5);
+    if (!tmp) {
+        return;
+    }
+    memcpy(tmp, g_dumpPath, len);
+    memcpy(tmp + len, ".tmp", 5);
+
+    FILE* fp = fopen(tmp, "w");
+    if (fp) {
+        Stats stats;
+        myStats(&stats);
+        printStats(fp, &stats);
+        if (fclose(fp) == 0) {
+            rename(tmp, g_dumpPath);
+        }
+    } else {
+        perror("Échec de l'écriture des statistiques");
+    }
+    free(tmp);
+}
+
+/**
+ * @brief Fil d'écriture périodique des compteurs.
+ */
+static void* dumpThread(void* arg) {
+    (void)arg;
+    pthread_mutex_lock(&g_dumpLock);
+    while (g_dumpRunning) {
+        struct timespec deadline;
+        clock_gettime(CLOCK_REALTIME, &deadline);
+        deadline.tv_sec += g_dumpInterval;
+        pthread_cond_timedwait(&g_dumpWake, &g_dumpLock, &deadline);
+        dumpStats();
+    }
+    pthread_mutex_unlock(&g_dumpLock);
+    return NULL;
+}
+
+int startStatsDump(const char* path, int intervalSeconds) {
+    if (g_dumpRunning || intervalSeconds < 1) {
+        return -1;
+    }
+    g_dumpPath = strdup(path);
+    if (!g_dumpPath) {
+        return -1;
+    }
+    g_dumpInterval = intervalSeconds;
+    g_dumpRunning = 1;
+    if (pthread_create(&g_dumpThread, NULL, dumpThread, NULL) != 0) {
+        perror("Échec du lancement de l'écriture des statistiques");
+        g_dumpRunning = 0;
+        free(g_dumpPath);
+        g_dumpPath = NULL;
+        return -1;
+    }
+    return 0;
+}
+
+void stopStatsDump(void) {
+    if (!g_dumpRunning) {
+        return;
+    }
+    pthread_mutex_lock(&g_dumpLock);
+    g_dumpRunning = 0;
+    pthread_cond_signal(&g_dumpWake);
+    pthread_mutex_unlock(&g_dumpLock);
+    pthread_join(g_dumpThread, NULL);
+    free(g_dumpPath);
+    g_dumpPath = NULL;
+}
@@ -0,0 +1,125 @@
+/**
+ * @file stats.h
+ * @brief Compteurs et histogrammes de latence des opérations du système de fichiers.
+ */
+
+#ifndef STATS_H
+#define STATS_H
+
+#include <stdint.h>
+#include <stdio.h>
+
+#define LATENCY_BUCKETS 40 /**< Classes de latence : [2^i, 2^(i+1)[ nanosecondes */
+
+/**
+ * @brief Opérations mesurées.
+ */
+typedef enum {
+    OP_FORMAT,   /**< myFormat */
+    OP_OPEN,     /**< myOpen */
+    OP_WRITE,    /**< myWrite */
+    OP_READ,     /**< myRead */
+    OP_SEEK,     /**< mySeek */
+    OP_SIZE,     /**< getFileSize */
+    OP_DELETE,   /**< myDelete */
+    OP_COPY,     /**< myCopy */
+    OP_RENAME,   /**< myRename */
+    OP_MOVE,     /**< myMove */
+    OP_CLOSE,    /**< myClose */
+    OP_ALLOCATE, /**< allocateBlocks */
+    OP_FREE,     /**< freeBlocks */
+    OP_COUNT     /**< Nombre d'opérations */
+} OpKind;
+
+/**
+ * @brief Compteurs d'une opération.
+ */
+typedef struct {
+    uint64_t calls; /**< Nombre d'appels */
+    uint64_t bytes; /**< Octets lus, écrits ou copiés */
+    uint64_t errors; /**< Appels ayant échoué */
+    uint64_t alloc_failures; /**< Échecs faute d'espace sur la partition */
+    uint64_t total_ns; /**< Temps cumulé */
+    uint64_t latency[LATENCY_BUCKETS]; /**< Histogramme des latences */
+} OpStats;
+
+/**
+ * @brief Compteurs de toutes les opérations.
+ */
+typedef struct {
+    OpStats ops[OP_COUNT]; /**< Compteurs par opération (indexés par OpKind) */
+} Stats;
+
+/**
+ * @brief Instrumentation active (1) ou non (0).
+ *
+ * Désactivée, chaque fonction publique ne paie qu'un test sur cette variable.
+ */
+extern int g_statsEnabled;
+
+/**
+ * @brief Active ou désactive l'instrumentation.
+ * @param enabled 1 pour activer, 0 pour désactiver.
+ */
+void setStatsEnabled(int enabled);
+
+/**
+ * @brief Horloge monotone en nanosecondes.
+ * @return L'instant courant.
+ */
+long long statsNow(void);
+
+/**
+ * @brief Enregistre un appel terminé dans les compteurs du fil courant.
+ * @param op L'opération.
+ * @param startNs L'instant de début (statsNow).
+ * @param failed 1 si l'appel a échoué.
+ * @param bytes Octets traités par l'appel.
+ */
+void statsRecord(OpKind op, long long startNs, int failed, long long bytes);
+
+/**
+ * @brief Compte un échec d'allocation faute d'espace.
+ * @param op L'opération concernée.
+ */
+void statsAllocFailure(OpKind op);
+
+/**
+ * @brief Fusionne les compteurs de tous les fils.
+ * @param out Structure à remplir.
+ */
+void myStats(Stats* out);
+
+/**
+ * @brief Remet tous les compteurs à zéro.
+ *
+ * Les compteurs des fils ne sont pas modifiés : leurs valeurs courantes
+ * deviennent la référence retranchée par myStats. Un fil peut donc
+ * continuer à compter pendant la remise à zéro.
+ */
+void resetStats(void);
+
+/**
+ * @brief Affiche un tableau des compteurs (appels, octets, erreurs, latences).
+ * @param out Flux de sortie.
+ * @param stats Compteurs fusionnés (myStats).
+ */
+void printStats(FILE* out, const Stats* stats);
+
+/**
+ * @brief Lance l'écriture périodique des compteurs dans un fichier.
+ *
+ * Le fichier est remplacé à chaque période (écriture dans un fichier
+ * temporaire puis renommage), il est donc toujours complet.
+ * @param path Chemin du fichier.
+ * @param intervalSeconds Période en secondes.
+ * @return 0 en cas de succès, -1 en cas d'échec.
+ */
+int startStatsDump(const char* path, int intervalSeconds);
+
+/**
+ * @brief Arrête l'écriture périodique après une dernière écriture.
+ */
+void stopStatsDump(void);
+
+#endif // STATS_H
@@ -3,15 +3,115 @@
  * @brief Implémentation des fonctions de test pour le système de fichiers.
  */
 
+#define _GNU_SOURCE // pour fallocate
 #include "test.h"
+#include "blockops.h"
+#include "hash.h"
+#include "lz.h"
+#include "stats.h"
+#include "trace.h"
+#include <errno.h> // pour errno, EOPNOTSUPP
+#include <fcntl.h> // pour open, fallocate
+#include <limits.h> // pour INT_MAX, PATH_MAX
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdint.h>
 #include <stdio.h>
-#include <stdlib.h> // pour malloc, free, realloc, exit
+#include <stdlib.h> // pour malloc, free, realloc, exit, realpath
 #include <string.h> // pour memset, memcpy, strcpy, strtok, strcspn
-#include <unistd.h> // pour chdir
+#include <time.h> // pour clock_gettime
+#include <sys/stat.h> // pour fstat, stat
+#include <unistd.h> // pour chdir, ftruncate, close, fsync
 
 // Définition de la variable globale de statut de partition
 PartitionStatus g_partitionStatus;
 
+#define DEDUP_INDEX_SIZE (2 * TOTAL_BLOCKS) /**< Nombre de cases de l'index de déduplication */
+#define DEDUP_CACHE_SIZE (256 * 1024) /**< Octets de contenu gardés en mémoire pour l'index de déduplication */
+#define DEDUP_CACHE_BLOCKS (DEDUP_CACHE_SIZE / BLOCK_SIZE) /**< Blocs indexés au plus */
+
+/**
+ * @brief Entrée de l'index de déduplication (empreinte vers numéro de bloc).
+ */
+typedef struct {
+    uint64_t hash; /**< Empreinte du contenu du bloc */
+    int block; /**< Numéro du bloc, -1 pour une case vide */
+} DedupEntry;
+
+static int g_dedupEnabled = 0; /**< Déduplication active pour les écritures */
+static DedupEntry g_dedupIndex[DEDUP_INDEX_SIZE]; /**< Index empreinte -> bloc */
+static uint64_t g_blockHash[TOTAL_BLOCKS]; /**< Empreinte de chaque bloc indexé */
+static char* g_blockContent[TOTAL_BLOCKS]; /**< Contenu de chaque bloc indexé (comparé avant partage), NULL s'il n'est pas dans l'index */
+static int g_dedupCached = 0; /**< Blocs indexés, donc copiés en mémoire */
+
+#define COMPRESS_MAGIC "MYLZ" /**< Signature des fichiers compressés */
+#define COMPRESS_VERSION 1 /**< Version du format des fichiers compressés */
+#define COMPRESS_CHUNK_BOUND (COMPRESS_CHUNK_SIZE + COMPRESS_CHUNK_SIZE / 255 + 16) /**< Taille compressée maximale d'un morceau */
+#define CHUNK_RAW 0x80000000u /**< Morceau stocké sans compression */
+
+/**
+ * @brief En-tête d'un fichier compressé, au début du fichier hôte.
+ */
+typedef struct {
+    char magic[4]; /**< COMPRESS_MAGIC */
+    uint16_t version; /**< COMPRESS_VERSION */
+    uint16_t flags; /**< Réservé, à zéro */
+    uint32_t size; /**< Taille logique du fichier */
+    uint32_t chunks; /**< Nombre d'entrées de la table des morceaux */
+    uint32_t map_offset; /**< Position de la table des morceaux */
+} CompressedHeader;
+
+static int g_compressionEnabled = 0; /**< Compression des fichiers créés par myOpen */
+
+#define DISCARD_BATCH 64 /**< Blocs en attente déclenchant une libération immédiate */
+#define DISCARD_DELAY_MS 200 /**< Délai de regroupement des libérations */
+
+static char g_partitionName[PATH_MAX] = ""; /**< Chemin absolu de l'image de la dernière partition formatée */
+static pthread_mutex_t g_discardLock = PTHREAD_MUTEX_INITIALIZER; /**< Protège la file de libération */
+static pthread_cond_t g_discardWake = PTHREAD_COND_INITIALIZER; /**< Réveille le fil de libération */
+static char g_discardPending[TOTAL_BLOCKS]; /**< 1 si le bloc attend d'être libéré dans l'image */
+static atomic_int g_discardCount = 0; /**< Nombre de blocs en attente */
+static char g_discardInFlight[TOTAL_BLOCKS]; /**< 1 si le bloc fait partie du lot en cours d'envoi */
+static atomic_int g_discardBusy = 0; /**< Un lot est en cours d'envoi */
+static pthread_cond_t g_discardDone = PTHREAD_COND_INITIALIZER; /**< Signale la fin d'un lot */
+static int g_discardThreadStarted = 0; /**< Fil de libération lancé */
+
+static atomic_int g_nextTraceId = 0; /**< Dernier identifiant de fichier attribué par myOpen */
+
+/**
+ * @brief Blocs d'un fichier fermé, repris à sa prochaine ouverture.
+ *
+ * Les données restent dans le fichier hôte ; sans cette table, myClose
+ * perdrait les blocs du fichier sur la partition et une nouvelle ouverture
+ * repartirait de zéro.
+ */
+typedef struct ClosedFile {
+    char* name; /**< Nom du fichier */
+    int host_size; /**< Taille du fichier hôte à la fermeture */
+    int accounted; /**< Taille physique réservée d'un fichier compressé */
+    int blocks_count; /**< Nombre de blocs pleins */
+    int* block_map; /**< Table des blocs */
+    int tail_block; /**< Bloc de queues, -1 si aucun */
+    int tail_offset; /**< Décalage de la queue dans son bloc */
+    int tail_size; /**< Taille de la queue */
+    struct ClosedFile* next; /**< Fichier fermé suivant */
+} ClosedFile;
+
+static ClosedFile* g_closedFiles = NULL; /**< Fichiers fermés qui gardent des blocs */
+
+/**
+ * @brief Nom d'un fichier compressé de la partition.
+ *
+ * Seuls les fichiers de cette liste sont lus comme compressés : un fichier
+ * ordinaire peut très bien commencer par COMPRESS_MAGIC.
+ */
+typedef struct CompressedName {
+    char* name; /**< Nom du fichier */
+    struct CompressedName* next; /**< Fichier compressé suivant */
+} CompressedName;
+
+static CompressedName* g_compressedFiles = NULL; /**< Fichiers compressés de la partition */
+
 /**
  * @brief Efface le tampon d'entrée.
  */
@@ -32,13 +132,209 @@ void displayCurrentDirectory() {
     }
 }
 
+/**
+ * @brief Classe de l'histogramme d'une zone libre (log2 de sa longueur).
+ */
+static inline int runBucket(int length) {
+    return 31 - __builtin_clz((unsigned)length);
+}
+
+/**
+ * @brief Enregistre une zone libre dans les statistiques.
+ * 
+ * @param start Le premier bloc de la zone.
+ * @param length La longueur de la zone.
+ */
+static void addFreeRun(int start, int length) {
+    PartitionStatus* p = &g_partitionStatus;
+    p->run_length[start] = length;
+    p->run_length[start + length - 1] = length;
+    p->runs_by_length[length]++;
+    p->run_histogram[runBucket(length)]++;
+    p->free_runs++;
+    if (length > p->largest_free_run) {
+        p->largest_free_run = length;
+    }
+}
+
+/**
+ * @brief Retire une zone libre des statistiques.
+ * 
+ * @param length La longueur de la zone.
+ */
+static void removeFreeRun(int length) {
+    PartitionStatus* p = &g_partitionStatus;
+    p->runs_by_length[length]--;
+    p->run_histogram[runBucket(length)]--;
+    p->free_runs--;
+    // Chercher la nouvelle plus grande zone seulement si la dernière disparaît
+    while (p->largest_free_run > 0 && p->runs_by_length[p->largest_free_run] == 0) {
+        p->largest_free_run--;
+    }
+}
+
+/**
+ * @brief Met à jour les zones libres quand des blocs libres deviennent utilisés.
+ * 
+ * @param start Le premier bloc (tous les blocs sont libres).
+ * @param count Le nombre de blocs.
+ */
+static void takeFromFreeRuns(int start, int count) {
+    PartitionStatus* p = &g_partitionStatus;
+    int runStart = start;
+    while (runStart > 0 && p->block_usage[runStart - 1] == '0') {
+        --runStart;  // Immédiat quand l'allocation commence une zone (premier trouvé)
+    }
+    int runLength = p->run_length[runStart];
+    int runEnd = runStart + runLength;
+
+    removeFreeRun(runLength);
+    if (start > runStart) {
+        addFreeRun(runStart, start - runStart);
+    }
+    if (start + count < runEnd) {
+        addFreeRun(start + count, runEnd - start - count);
+    }
+    p->free_blocks -= count;
+}
+
+/**
+ * @brief Met à jour les zones libres quand des blocs utilisés sont libérés.
+ *
+ * La nouvelle zone est fusionnée avec ses voisines grâce aux longueurs
+ * notées aux extrémités des zones.
+ * 
+ * @param start Le premier bloc (tous les blocs sont utilisés).
+ * @param count Le nombre de blocs.
+ */
+static void returnToFreeRuns(int start, int count) {
+    PartitionStatus* p = &g_partitionStatus;
+    int runStart = start;
+    int runEnd = start + count;
+    if (runStart > 0 && p->block_usage[runStart - 1] == '0') {
+        int left = p->run_length[runStart - 1];
+        removeFreeRun(left);
+        runStart -= left;
+    }
+    if (runEnd < TOTAL_BLOCKS && p->block_usage[runEnd] == '0') {
+        int right = p->run_length[runEnd];
+        removeFreeRun(right);
+        runEnd += right;
+    }
+    addFreeRun(runStart, runEnd - runStart);
+    p->free_blocks += count;
+}
+
+/**
+ * @brief Oublie les fichiers fermés sans rendre leurs blocs (partition réinitialisée).
+ */
+static void forgetClosedFiles(void) {
+    while (g_closedFiles) {
+        ClosedFile* next = g_closedFiles->next;
+        free(g_closedFiles->name);
+        free(g_closedFiles->block_map);
+        free(g_closedFiles);
+        g_closedFiles = next;
+    }
+}
+
+/**
+ * @brief Cherche un fichier compressé par son nom.
+ * 
+ * @param name Le nom du fichier.
+ * @return L'adresse du lien qui le désigne, ou du lien final NULL s'il n'y est pas.
+ */
+static CompressedName** findCompressed(const char* name) {
+    CompressedName** link = &g_compressedFiles;
+    while (*link && strcmp((*link)->name, name) != 0) {
+        link = &(*link)->next;
+    }
+    return link;
+}
+
+/**
+ * @brief Indique si un fichier est compressé.
+ */
+static int isCompressed(const char* name) {
+    return *findCompressed(name) != NULL;
+}
+
+/**
+ * @brief Note qu'un fichier est compressé ou ordinaire.
+ * 
+ * @param name Le nom du fichier.
+ * @param compressed 1 si le fichier est compressé, 0 sinon.
+ * @return 0 en cas de réussite, -1 en cas d'échec d'allocation.
+ */
+static int markCompressed(const char* name, int compressed) {
+    CompressedName** link = findCompressed(name);
+    if (!compressed && *link) {
+        CompressedName* entry = *link;
+        *link = entry->next;
+        free(entry->name);
+        free(entry);
+    } else if (compressed && !*link) {
+        CompressedName* entry = (CompressedName*)malloc(sizeof(CompressedName));
+        char* copy = entry ? strdup(name) : NULL;
+        if (!copy) {
+            perror("Échec de l'allocation d'un nom de fichier compressé");
+            free(entry);
+            return -1;
+        }
+        entry->name = copy;
+        entry->next = g_compressedFiles;
+        g_compressedFiles = entry;
+    }
+    return 0;
+}
+
+/**
+ * @brief Reporte la compression d'un fichier sur son nouveau nom.
+ */
+static void renameCompressed(const char* oldName, const char* newName) {
+    markCompressed(newName, isCompressed(oldName));
+    markCompressed(oldName, 0);
+}
+
+/**
+ * @brief Oublie les fichiers compressés (partition réinitialisée).
+ */
+static void forgetCompressedFiles(void) {
+    while (g_compressedFiles) {
+        markCompressed(g_compressedFiles->name, 0);
+    }
+}
+
 /**
  * @brief Initialise le statut de la partition à tous libres ('0').
  * 
  * @return Un pointeur vers le statut de partition initialisé.
  */
 PartitionStatus* initializePartitionStatus() {
+    forgetClosedFiles();
+    forgetCompressedFiles();
     memset(g_partitionStatus.block_usage, '0', TOTAL_BLOCKS);
+    memset(g_partitionStatus.runs_by_length, 0, sizeof(g_partitionStatus.runs_by_length));
+    memset(g_partitionStatus.run_histogram, 0, sizeof(g_partitionStatus.run_histogram));
+    memset(g_partitionStatus.cell_used, 0, sizeof(g_partitionStatus.cell_used));
+    memset(g_partitionStatus.cell_tails, 0, sizeof(g_partitionStatus.cell_tails));
+    g_partitionStatus.free_runs = 0;
+    g_partitionStatus.largest_free_run = 0;
+    g_partitionStatus.free_blocks = TOTAL_BLOCKS;
+    addFreeRun(0, TOTAL_BLOCKS);  // Une seule zone libre couvrant toute la partition
+    memset(g_partitionStatus.tail_used, 0, sizeof(g_partitionStatus.tail_used));
+    memset(g_partitionStatus.tail_refs, 0, sizeof(g_partitionStatus.tail_refs));
+    memset(g_partitionStatus.block_refs, 0, sizeof(g_partitionStatus.block_refs));
+    g_partitionStatus.tail_cursor = -1;
+    g_blockKernels = selectBlockKernels(BLOCK_SIZE);  // Choisis une fois au montage
+    for (int i = 0; i < DEDUP_INDEX_SIZE; ++i) {
+        g_dedupIndex[i].block = -1;
+    }
+    for (int i = 0; i < TOTAL_BLOCKS; ++i) {
+        free(g_blockContent[i]);
+        g_blockContent[i] = NULL;
+    }
+    g_dedupCached = 0;
     return &g_partitionStatus;
 }
 
@@ -48,12 +344,292 @@ PartitionStatus* initializePartitionStatus() {
  * @param status Le statut de la partition à visualiser.
  */
 void visualizePartitionStatus(PartitionStatus* status) {
-    for (int i = 0; i < TOTAL_BLOCKS; i++) {
-        printf("%c", status->block_usage[i] == '0' ? '.' : '*');
-        if ((i + 1) % 64 == 0) printf("\n");
+    static const char* labels[] = {"1", "2-3", "4-7", "8-15", "16-31", "32-63", "64-127",
+                                   "128-255", "256-511", "512-1023", "1024-2047"};
+    char out[VIS_CELLS + VIS_CELLS / VIS_COLUMNS + 2048];
+    int len = 0;
+
+    for (int i = 0; i < VIS_CELLS; i++) {
+        int blocks = TOTAL_BLOCKS - i * VIS_CELL_BLOCKS;
+        if (blocks > VIS_CELL_BLOCKS) blocks = VIS_CELL_BLOCKS;
+        int used = status->cell_used[i];
+        char c = ':';
+        if (used == 0) c = '.';
+        else if (used == blocks) c = status->cell_tails[i] > 0 ? '+' : '*';
+        out[len++] = c;
+        if ((i + 1) % VIS_COLUMNS == 0) out[len++] = '\n';
+    }
+    if (VIS_CELLS % VIS_COLUMNS != 0) out[len++] = '\n';
+
+    int largest = status->largest_free_run;
+    len += snprintf(out + len, sizeof(out) - len,
+                    "Blocs libres : %d / %d (%.1f %%), %d bloc(s) par caractère\n"
+                    "Plus grande zone libre : %d blocs, %d zone(s) libre(s), fragmentation : %.3f\n",
+                    status->free_blocks, TOTAL_BLOCKS, 100.0 * status->free_blocks / TOTAL_BLOCKS,
+                    VIS_CELL_BLOCKS, largest, status->free_runs,
+                    status->free_blocks > 0 ? 1.0 - (double)largest / status->free_blocks : 0.0);
+    for (int i = 0; i < RUN_HISTOGRAM_BUCKETS && len < (int)sizeof(out); i++) {
+        if (status->run_histogram[i] == 0) continue;
+        if (i < (int)(sizeof(labels) / sizeof(labels[0]))) {
+            len += snprintf(out + len, sizeof(out) - len, "  zones de %s blocs : %d\n", labels[i], status->run_histogram[i]);
+        } else {
+            len += snprintf(out + len, sizeof(out) - len, "  zones de 2^%d blocs et plus : %d\n", i, status->run_histogram[i]);
+        }
+    }
+    if (len > (int)sizeof(out)) len = sizeof(out);
+
+    // Un seul appel système pour tout l'affichage
+    fflush(stdout);
+    if (write(STDOUT_FILENO, out, len) < 0) {
+        perror("Échec de l'affichage de la partition");
+    }
+}
+
+/**
+ * @brief Obtient le résumé de l'espace libre en temps constant.
+ * 
+ * @param report La structure à remplir.
+ */
+void getSpaceReport(SpaceReport* report) {
+    PartitionStatus* p = &g_partitionStatus;
+    report->total_blocks = TOTAL_BLOCKS;
+    report->free_blocks = p->free_blocks;
+    report->free_runs = p->free_runs;
+    report->largest_free_run = p->largest_free_run;
+    memcpy(report->run_histogram, p->run_histogram, sizeof(report->run_histogram));
+    report->fragmentation = p->free_blocks > 0 ? 1.0 - (double)p->largest_free_run / p->free_blocks : 0.0;
+}
+
+/**
+ * @brief Rend au système hôte une étendue de l'image.
+ * @return 0 en cas de succès, -1 en cas d'échec.
+ */
+static int punchExtent(int fd, long long offset, long long length) {
+    if (length == 0 || fd == -1) {
+        return 0;
+    }
+    if (fallocate(fd, FALLOC_FL_PUNCH_HOLE | FALLOC_FL_KEEP_SIZE, offset, length) == -1) {
+        perror("Échec de la libération de l'espace de la partition");
+        return -1;
+    }
+    return 0;
+}
+
+/**
+ * @brief Remet en attente les blocs du lot compris dans [from, to[ (verrou g_discardLock tenu).
+ */
+static void requeueInFlightLocked(int from, int to) {
+    for (int i = from; i < to; ++i) {
+        if (g_discardInFlight[i] && !g_discardPending[i]) {
+            g_discardPending[i] = 1;
+            atomic_fetch_add(&g_discardCount, 1);
+        }
+    }
+}
+
+/**
+ * @brief Envoie à l'image un lot de blocs libérés, sans tenir g_discardLock.
+ *
+ * Les blocs consécutifs sont regroupés en étendues, chacune rendue au
+ * système hôte par fallocate(FALLOC_FL_PUNCH_HOLE) : l'image garde sa
+ * taille mais n'occupe plus d'espace physique pour ces blocs. Les blocs
+ * d'une étendue en échec sont remis en attente pour la passe suivante, sauf
+ * si le système de fichiers hôte ne sait pas libérer d'espace.
+ */
+static void punchInFlight(void) {
+    int fd = open(g_partitionName, O_WRONLY);
+    if (fd == -1) {
+        perror("Échec de l'ouverture de la partition pour libérer l'espace");
+        return;
+    }
+    for (int i = 0; i < TOTAL_BLOCKS; ) {
+        if (!g_discardInFlight[i]) {
+            ++i;
+            continue;
+        }
+        int start = i;
+        while (i < TOTAL_BLOCKS && g_discardInFlight[i]) {
+            ++i;
+        }
+        if (punchExtent(fd, (long long)start * BLOCK_SIZE, (long long)(i - start) * BLOCK_SIZE) == -1 &&
+            errno != EOPNOTSUPP) {
+            pthread_mutex_lock(&g_discardLock);
+            requeueInFlightLocked(start, i);
+            pthread_mutex_unlock(&g_discardLock);
+        }
+    }
+    close(fd);
+}
+
+/**
+ * @brief Envoie à l'image toutes les libérations en attente.
+ *
+ * Le lot est retiré de la file sous le verrou, puis envoyé sans le tenir :
+ * les blocs libérés pendant ce temps s'accumulent pour le lot suivant. Un
+ * seul lot est en cours à la fois ; cancelDiscard attend sa fin avant de
+ * laisser réattribuer l'un de ses blocs.
+ */
+static void punchPending(void) {
+    pthread_mutex_lock(&g_discardLock);
+    while (g_discardBusy) {
+        pthread_cond_wait(&g_discardDone, &g_discardLock);
+    }
+    if (atomic_load(&g_discardCount) == 0 || g_partitionName[0] == '\0') {
+        pthread_mutex_unlock(&g_discardLock);
+        return;
+    }
+    memcpy(g_discardInFlight, g_discardPending, sizeof(g_discardInFlight));
+    memset(g_discardPending, 0, sizeof(g_discardPending));
+    atomic_store(&g_discardCount, 0);
+    atomic_store(&g_discardBusy, 1);
+    pthread_mutex_unlock(&g_discardLock);
+
+    punchInFlight();
+
+    pthread_mutex_lock(&g_discardLock);
+    memset(g_discardInFlight, 0, sizeof(g_discardInFlight));
+    atomic_store(&g_discardBusy, 0);
+    pthread_cond_broadcast(&g_discardDone);
+    pthread_mutex_unlock(&g_discardLock);
+}
+
+/**
+ * @brief Fil d'arrière-plan qui regroupe et envoie les libérations d'espace.
+ *
+ * Il attend qu'un bloc soit libéré, laisse DISCARD_DELAY_MS aux libérations
+ * suivantes pour s'accumuler (ou DISCARD_BATCH blocs), puis les traite en
+ * une seule passe.
+ */
+static void* discardThread(void* arg) {
+    (void)arg;
+    for (;;) {
+        pthread_mutex_lock(&g_discardLock);
+        while (atomic_load(&g_discardCount) == 0) {
+            pthread_cond_wait(&g_discardWake, &g_discardLock);
+        }
+        struct timespec deadline;
+        clock_gettime(CLOCK_REALTIME, &deadline);
+        deadline.tv_nsec += DISCARD_DELAY_MS * 1000000L;
+        deadline.tv_sec += deadline.tv_nsec / 1000000000L;
+        deadline.tv_nsec %= 1000000000L;
+        while (atomic_load(&g_discardCount) > 0 && atomic_load(&g_discardCount) < DISCARD_BATCH &&
+               pthread_cond_timedwait(&g_discardWake, &g_discardLock, &deadline) == 0) {
+            // Attendre d'autres libérations
+        }
+        pthread_mutex_unlock(&g_discardLock);
+        punchPending();
+    }
+    return NULL;
+}
+
+/**
+ * @brief Met des blocs libérés en attente de libération dans l'image.
+ * 
+ * @param start Le premier bloc.
+ * @param count Le nombre de blocs.
+ */
+static void queueDiscard(int start, int count) {
+    if (g_partitionName[0] == '\0') {
+        return;  // Aucune image formatée
+    }
+    pthread_mutex_lock(&g_discardLock);
+    for (int i = start; i < start + count; ++i) {
+        if (!g_discardPending[i]) {
+            g_discardPending[i] = 1;
+            atomic_fetch_add(&g_discardCount, 1);
+        }
+    }
+    int threadless = 0;
+    if (!g_discardThreadStarted) {
+        pthread_t thread;
+        if (pthread_create(&thread, NULL, discardThread, NULL) == 0) {
+            pthread_detach(thread);
+            g_discardThreadStarted = 1;
+        } else {
+            threadless = 1;
+        }
+    }
+    pthread_cond_signal(&g_discardWake);
+    pthread_mutex_unlock(&g_discardLock);
+    if (threadless) {
+        punchPending();  // Pas de fil : traiter tout de suite
+    }
+}
+
+/**
+ * @brief Retire des blocs réutilisés de la file de libération.
+ *
+ * Sans cela, le fil d'arrière-plan pourrait effacer un bloc qui vient
+ * d'être réattribué. Si l'un des blocs fait partie du lot en cours d'envoi,
+ * attendre la fin du lot. Le verrou n'est pris que si des blocs sont en
+ * attente ou en cours d'envoi.
+ * 
+ * @param start Le premier bloc.
+ * @param count Le nombre de blocs.
+ */
+static void cancelDiscard(int start, int count) {
+    if (atomic_load(&g_discardCount) == 0 && !atomic_load(&g_discardBusy)) {
+        return;
+    }
+    pthread_mutex_lock(&g_discardLock);
+    for (int i = start; i < start + count && g_discardBusy; ++i) {
+        if (g_discardInFlight[i]) {
+            while (g_discardBusy) {
+                pthread_cond_wait(&g_discardDone, &g_discardLock);
+            }
+        }
     }
+    for (int i = start; i < start + count; ++i) {
+        if (g_discardPending[i]) {
+            g_discardPending[i] = 0;
+            atomic_fetch_sub(&g_discardCount, 1);
+        }
+    }
+    pthread_mutex_unlock(&g_discardLock);
+}
+
+/**
+ * @brief Envoie immédiatement à l'image toutes les libérations en attente.
+ */
+void flushDiscards(void) {
+    punchPending();
 }
 
+/**
+ * @brief Change l'état d'une suite de blocs dans la table d'occupation.
+ * 
+ * @param start Le premier bloc.
+ * @param count Le nombre de blocs.
+ * @param state Le nouvel état ('0' libre, '1' utilisé, 'q' bloc de queues).
+ */
+static void markBlocks(int start, int count, char state) {
+    PartitionStatus* p = &g_partitionStatus;
+    int end = start + count;
+    for (int a = start; a < end; ) {
+        // Traiter ensemble les blocs qui étaient tous libres ou tous utilisés
+        int wasFree = p->block_usage[a] == '0';
+        int b = wasFree ? g_blockKernels->next_used(p->block_usage, a + 1, end)
+                        : g_blockKernels->next_free(p->block_usage, a + 1, end);
+        if (wasFree && state != '0') {
+            takeFromFreeRuns(a, b - a);
+        } else if (!wasFree && state == '0') {
+            returnToFreeRuns(a, b - a);
+        }
+        for (int i = a; i < b; ++i) {
+            char old = p->block_usage[i];
+            p->cell_used[i / VIS_CELL_BLOCKS] += (state != '0') - (old != '0');
+            p->cell_tails[i / VIS_CELL_BLOCKS] += (state == 'q') - (old == 'q');
+        }
+        memset(p->block_usage + a, state, b - a);
+        a = b;
+    }
+
+    if (state == '0') {
+        queueDiscard(start, count);
+    } else {
+        cancelDiscard(start, count);
+    }
+}
 
 /**
  * @brief Trouve des blocs libres consécutifs.
@@ -62,39 +638,185 @@ void visualizePartitionStatus(PartitionStatus* status) {
  * @return L'index du premier bloc libre trouvé, -1 s'il n'y en a pas assez.
  */
 int findFreeBlocks(int blocksNeeded) {
-    int freeCount = 0;
-    for (int i = 0; i < TOTAL_BLOCKS; ++i) {
+    if (blocksNeeded > g_partitionStatus.largest_free_run) {
+        return -1;  // Aucune zone libre assez grande
+    }
+    for (int i = 0; i < TOTAL_BLOCKS; ) {
         if (g_partitionStatus.block_usage[i] == '0') {
-            ++freeCount;
-            if (freeCount == blocksNeeded) {
-                return i - blocksNeeded + 1;  // Index du bloc de départ
+            int runLength = g_partitionStatus.run_length[i];  // i commence une zone libre
+            if (runLength >= blocksNeeded) {
+                return i;  // Index du bloc de départ
             }
+            i += runLength;  // Sauter toute la zone
         } else {
-            freeCount = 0;  // Réinitialiser le compteur
+            i = g_blockKernels->next_free(g_partitionStatus.block_usage, i + 1, TOTAL_BLOCKS);
         }
     }
     return -1;  // Pas assez de blocs libres trouvés
 }
 
 /**
- * @brief Alloue des blocs pour le fichier.
+ * @brief Place une queue de fichier dans un bloc de queues partagé.
+ *
+ * Les queues sont ajoutées les unes après les autres dans le bloc courant ;
+ * un nouveau bloc est ouvert lorsque la place manque. L'espace d'une queue
+ * libérée n'est récupéré que lorsque toutes les queues du bloc sont libérées.
  * 
  * @param f Le pointeur vers la structure de fichier.
- * @param size La taille du fichier à allouer.
- * @return Le nombre de blocs alloués ou -1 s'il n'y a pas assez d'espace.
+ * @param tailSize La taille de la queue en octets.
+ * @return 0 en cas de réussite, -1 s'il n'y a plus de bloc libre.
  */
-int allocateBlocks(file* f, int size) {
-    int blocksNeeded = (size + BLOCK_SIZE - 1) / BLOCK_SIZE;
-    int startBlock = findFreeBlocks(blocksNeeded);
-    if (startBlock == -1) {
-        return -1;  // Pas assez d'espace
+static int allocateTail(file* f, int tailSize) {
+    int block = g_partitionStatus.tail_cursor;
+    if (block == -1 || g_partitionStatus.tail_used[block] + tailSize > BLOCK_SIZE) {
+        block = findFreeBlocks(1);
+        if (block == -1) {
+            return -1;
+        }
+        markBlocks(block, 1, 'q');  // Nouveau bloc de queues
+        g_partitionStatus.tail_used[block] = 0;
+        g_partitionStatus.tail_refs[block] = 0;
+        g_partitionStatus.tail_cursor = block;
+    }
+    f->tail_block = block;
+    f->tail_offset = g_partitionStatus.tail_used[block];
+    f->tail_size = tailSize;
+    g_partitionStatus.tail_used[block] += tailSize;
+    g_partitionStatus.tail_refs[block]++;
+    return 0;
+}
+
+/**
+ * @brief Libère la queue d'un fichier dans son bloc partagé.
+ * 
+ * @param f Le pointeur vers la structure de fichier.
+ */
+static void freeTail(file* f) {
+    int block = f->tail_block;
+    if (block == -1) {
+        return;
     }
-    for (int i = startBlock; i < startBlock + blocksNeeded; ++i) {
-        g_partitionStatus.block_usage[i] = '1';  // Marquer le bloc comme utilisé
+    if (--g_partitionStatus.tail_refs[block] == 0) {
+        markBlocks(block, 1, '0');  // Plus aucune queue : rendre le bloc
+        g_partitionStatus.tail_used[block] = 0;
+        if (g_partitionStatus.tail_cursor == block) {
+            g_partitionStatus.tail_cursor = -1;
+        }
     }
-    f->block_start = startBlock;
-    f->blocks_count = blocksNeeded;
-    return blocksNeeded;
+    f->tail_block = -1;
+    f->tail_offset = 0;
+    f->tail_size = 0;
+}
+
+/**
+ * @brief Cherche un bloc de contenu identique dans l'index de déduplication.
+ *
+ * L'empreinte ne fait que désigner des candidats : un bloc n'est retenu que
+ * si son contenu est identique octet pour octet, et s'il peut encore
+ * recevoir une référence.
+ * 
+ * @param hash L'empreinte du contenu recherché.
+ * @param data Le contenu recherché (BLOCK_SIZE octets).
+ * @return Le numéro du bloc, -1 s'il n'est pas indexé.
+ */
+static int dedupLookup(uint64_t hash, const char* data) {
+    for (int slot = hash % DEDUP_INDEX_SIZE; g_dedupIndex[slot].block != -1;
+         slot = (slot + 1) % DEDUP_INDEX_SIZE) {
+        int block = g_dedupIndex[slot].block;
+        if (g_dedupIndex[slot].hash == hash && g_partitionStatus.block_refs[block] < INT_MAX &&
+            memcmp(g_blockContent[block], data, BLOCK_SIZE) == 0) {
+            return block;
+        }
+    }
+    return -1;
+}
+
+/**
+ * @brief Ajoute un bloc à l'index de déduplication.
+ *
+ * Le contenu des blocs indexés est gardé en mémoire dans la limite de
+ * DEDUP_CACHE_SIZE octets : au-delà, ou sans mémoire pour la copie, le
+ * bloc n'est simplement pas indexé et ne sera pas partagé.
+ * 
+ * @param hash L'empreinte du contenu du bloc.
+ * @param block Le numéro du bloc.
+ * @param data Le contenu du bloc (BLOCK_SIZE octets).
+ */
+static void dedupInsert(uint64_t hash, int block, const char* data) {
+    char* content = g_dedupCached < DEDUP_CACHE_BLOCKS ? (char*)malloc(BLOCK_SIZE) : NULL;
+    if (!content) {
+        return;
+    }
+    g_dedupCached++;
+    memcpy(content, data, BLOCK_SIZE);
+    int slot = hash % DEDUP_INDEX_SIZE;
+    while (g_dedupIndex[slot].block != -1) {
+        slot = (slot + 1) % DEDUP_INDEX_SIZE;
+    }
+    g_dedupIndex[slot].hash = hash;
+    g_dedupIndex[slot].block = block;
+    g_blockHash[block] = hash;
+    g_blockContent[block] = content;
+}
+
+/**
+ * @brief Retire un bloc de l'index de déduplication.
+ *
+ * Les entrées suivantes de la même grappe sont recalées pour que les
+ * recherches n'aient jamais à sauter de case vide.
+ * 
+ * @param block Le numéro du bloc à retirer.
+ */
+static void dedupRemove(int block) {
+    int slot = g_blockHash[block] % DEDUP_INDEX_SIZE;
+    while (g_dedupIndex[slot].block != block) {
+        slot = (slot + 1) % DEDUP_INDEX_SIZE;
+    }
+    free(g_blockContent[block]);
+    g_blockContent[block] = NULL;
+    g_dedupCached--;
+
+    int hole = slot;
+    for (int next = (hole + 1) % DEDUP_INDEX_SIZE; g_dedupIndex[next].block != -1;
+         next = (next + 1) % DEDUP_INDEX_SIZE) {
+        int home = g_dedupIndex[next].hash % DEDUP_INDEX_SIZE;
+        // L'entrée peut combler le trou si sa case d'origine n'est pas entre le trou et elle
+        int between = hole <= next ? (home > hole && home <= next) : (home > hole || home <= next);
+        if (!between) {
+            g_dedupIndex[hole] = g_dedupIndex[next];
+            hole = next;
+        }
+    }
+    g_dedupIndex[hole].block = -1;
+}
+
+/**
+ * @brief Réserve un bloc de données libre.
+ * 
+ * @return Le numéro du bloc, -1 si la partition est pleine.
+ */
+static int takeFreeBlock(void) {
+    int block = findFreeBlocks(1);
+    if (block != -1) {
+        markBlocks(block, 1, '1');
+        g_partitionStatus.block_refs[block] = 1;
+    }
+    return block;
+}
+
+/**
+ * @brief Retire une référence à un bloc de données et le libère à la dernière.
+ * 
+ * @param block Le numéro du bloc.
+ */
+static void releaseBlock(int block) {
+    if (--g_partitionStatus.block_refs[block] > 0) {
+        return;  // Encore partagé par un autre fichier
+    }
+    if (g_blockContent[block]) {
+        dedupRemove(block);
+    }
+    markBlocks(block, 1, '0');  // Marquer le bloc comme libre
 }
 
 /**
@@ -102,46 +824,1005 @@ int allocateBlocks(file* f, int size) {
  * 
  * @param f Le pointeur vers la structure de fichier.
  */
-void freeBlocks(file* f) {
-    for (int i = f->block_start; i < f->block_start + f->blocks_count; ++i) {
-        g_partitionStatus.block_usage[i] = '0';  // Marquer le bloc comme libre
+static void freeFileBlocks(file* f) {
+    for (int i = 0; i < f->blocks_count; ++i) {
+        if (f->block_map[i] != -1) {
+            releaseBlock(f->block_map[i]);
+        }
     }
+    free(f->block_map);
+    f->block_map = NULL;
+    f->block_start = -1;
+    f->blocks_count = 0;
+    freeTail(f);
 }
 
 /**
- * @brief Obtient la taille du fichier.
+ * @brief Cherche un fichier fermé par son nom.
  * 
- * @param f Le pointeur vers la structure de fichier.
- * @return La taille du fichier ou -1 en cas d'erreur.
+ * @param name Le nom du fichier.
+ * @return L'adresse du lien qui le désigne, ou du lien final NULL s'il n'y est pas.
  */
-int getFileSize(const file* f) {
-    return f ? f->size : -1;
+static ClosedFile** findClosed(const char* name) {
+    ClosedFile** link = &g_closedFiles;
+    while (*link && strcmp((*link)->name, name) != 0) {
+        link = &(*link)->next;
+    }
+    return link;
+}
+
+/**
+ * @brief Rend les blocs d'un fichier fermé et l'oublie.
+ * 
+ * @param name Le nom du fichier (rien n'est fait s'il n'est pas dans la table).
+ */
+static void dropClosed(const char* name) {
+    ClosedFile** link = findClosed(name);
+    ClosedFile* closed = *link;
+    if (!closed) {
+        return;
+    }
+    *link = closed->next;
+    file owner;
+    owner.block_map = closed->block_map;
+    owner.blocks_count = closed->blocks_count;
+    owner.tail_block = closed->tail_block;
+    owner.tail_offset = closed->tail_offset;
+    owner.tail_size = closed->tail_size;
+    freeFileBlocks(&owner);
+    free(closed->name);
+    free(closed);
+}
+
+/**
+ * @brief Renomme un fichier fermé après un renommage sur l'hôte.
+ * 
+ * @param oldName L'ancien nom.
+ * @param newName Le nouveau nom (un fichier fermé de ce nom a été remplacé).
+ */
+static void renameClosed(const char* oldName, const char* newName) {
+    dropClosed(newName);
+    ClosedFile* closed = *findClosed(oldName);
+    char* name = closed ? strdup(newName) : NULL;
+    if (name) {
+        free(closed->name);
+        closed->name = name;
+    } else if (closed) {
+        dropClosed(oldName);  // Impossible de le renommer : ne pas garder de blocs orphelins
+    }
+}
+
+/**
+ * @brief Garde les blocs d'un fichier qu'on ferme pour sa prochaine ouverture.
+ *
+ * Un fichier dans l'inode n'a rien à garder. Si un autre descripteur du même
+ * fichier a déjà été fermé, ses blocs sont rendus : le dernier fermé décrit
+ * le contenu courant.
+ * 
+ * @param f Le pointeur vers la structure de fichier (ses blocs lui sont retirés).
+ */
+static void keepClosed(file* f) {
+    dropClosed(f->name);
+    if (f->blocks_count == 0 && f->tail_block == -1) {
+        free(f->block_map);
+        f->block_map = NULL;
+        return;
+    }
+    struct stat host;
+    if (stat(f->name, &host) != 0) {
+        freeFileBlocks(f);  // Plus de fichier hôte : rien à reprendre
+        return;
+    }
+    ClosedFile* closed = (ClosedFile*)malloc(sizeof(ClosedFile));
+    char* name = closed ? strdup(f->name) : NULL;
+    if (!name) {
+        perror("Échec de l'allocation d'un fichier fermé");
+        free(closed);
+        freeFileBlocks(f);  // Rendre les blocs plutôt que les perdre
+        return;
+    }
+    closed->name = name;
+    closed->host_size = (int)host.st_size;
+    closed->accounted = f->compression ? f->compression->accounted : 0;
+    closed->blocks_count = f->blocks_count;
+    closed->block_map = f->block_map;
+    closed->tail_block = f->tail_block;
+    closed->tail_offset = f->tail_offset;
+    closed->tail_size = f->tail_size;
+    closed->next = g_closedFiles;
+    g_closedFiles = closed;
+    f->block_map = NULL;
+    f->blocks_count = 0;
+    f->tail_block = -1;
+}
+
+/**
+ * @brief Reprend les blocs d'un fichier fermé à son ouverture.
+ *
+ * Si le fichier hôte a changé de taille depuis la fermeture, les blocs
+ * gardés ne le décrivent plus : ils sont rendus.
+ * 
+ * @param f Le pointeur vers la structure de fichier qu'on ouvre.
+ * @param hostSize La taille du fichier hôte.
+ */
+static void adoptClosed(file* f, int hostSize) {
+    ClosedFile** link = findClosed(f->name);
+    ClosedFile* closed = *link;
+    if (!closed) {
+        return;
+    }
+    if (closed->host_size != hostSize) {
+        dropClosed(f->name);
+        return;
+    }
+    *link = closed->next;
+    f->block_map = closed->block_map;
+    f->blocks_count = closed->blocks_count;
+    f->block_start = closed->blocks_count > 0 ? closed->block_map[0] : -1;
+    f->tail_block = closed->tail_block;
+    f->tail_offset = closed->tail_offset;
+    f->tail_size = closed->tail_size;
+    if (f->compression) {
+        f->compression->accounted = closed->accounted;
+    }
+    free(closed->name);
+    free(closed);
+}
+
+/**
+ * @brief Alloue des blocs pour le fichier.
+ * 
+ * @param f Le pointeur vers la structure de fichier.
+ * @param size La taille du fichier à allouer.
+ * @return Le nombre de blocs pleins alloués ou -1 s'il n'y a pas assez d'espace.
+ */
+static int allocateFileBlocks(file* f, int size) {
+    f->block_start = -1;
+    f->blocks_count = 0;
+    f->block_map = NULL;
+    f->tail_block = -1;
+    f->tail_offset = 0;
+    f->tail_size = 0;
+
+    // Petit fichier : les données restent dans l'inode
+    f->inline_data = size <= INLINE_DATA_SIZE;
+    if (f->inline_data) {
+        return 0;
+    }
+
+    int blocksNeeded = blockIndex(size);
+    int tailSize = blockOffset(size);
+    if (tailSize > TAIL_MAX_SIZE) {
+        ++blocksNeeded;  // Queue trop grande pour être partagée
+        tailSize = 0;
+    }
+
+    if (blocksNeeded > 0) {
+        int startBlock = findFreeBlocks(blocksNeeded);
+        if (startBlock == -1) {
+            return -1;  // Pas assez d'espace
+        }
+        f->block_map = (int*)malloc(blocksNeeded * sizeof(int));
+        if (!f->block_map) {
+            perror("Échec de l'allocation de la table des blocs");
+            return -1;
+        }
+        markBlocks(startBlock, blocksNeeded, '1');  // Marquer les blocs comme utilisés
+        for (int i = 0; i < blocksNeeded; ++i) {
+            g_partitionStatus.block_refs[startBlock + i] = 1;
+            f->block_map[i] = startBlock + i;
+        }
+        f->block_start = startBlock;
+        f->blocks_count = blocksNeeded;
+    }
+
+    if (tailSize > 0 && allocateTail(f, tailSize) == -1) {
+        freeFileBlocks(f);  // Annuler l'allocation des blocs pleins
+        return -1;
+    }
+    return blocksNeeded;
+}
+
+/**
+ * @brief Agrandit l'allocation d'un fichier sans déplacer ses blocs existants.
+ *
+ * Les nouveaux blocs pleins sont ajoutés à la fin de la table des blocs et
+ * la queue est replacée ; les blocs déjà partagés par déduplication le restent.
+ * 
+ * @param f Le pointeur vers la structure de fichier.
+ * @param newSize La nouvelle taille du fichier.
+ * @param holeEnd Début des données écrites : les blocs entre l'ancienne fin
+ *        du fichier et cette position ne sont pas alloués (0 pour aucun trou).
+ * @return 0 en cas de réussite, -1 s'il n'y a pas assez d'espace.
+ */
+static int growBlocks(file* f, int newSize, int holeEnd) {
+    if (f->inline_data && newSize <= INLINE_DATA_SIZE) {
+        return 0;  // Toujours dans l'inode
+    }
+
+    int fullBlocks = blockIndex(newSize);
+    int tailSize = blockOffset(newSize);
+    if (tailSize > TAIL_MAX_SIZE) {
+        ++fullBlocks;
+        tailSize = 0;
+    }
+    if (fullBlocks < f->blocks_count) {
+        // Blocs déjà réservés par une écriture qui a échoué : la fin tombe dans l'un d'eux
+        fullBlocks = f->blocks_count;
+        tailSize = 0;
+    }
+
+    // Les blocs entièrement situés entre l'ancienne fin et holeEnd restent des trous
+    int oldCount = f->blocks_count;
+    int firstHole = blocksFor(f->size);
+    int endHole = blockIndex(holeEnd);
+    if (firstHole < oldCount) {
+        firstHole = oldCount;
+    }
+    if (endHole > fullBlocks) {
+        endHole = fullBlocks;
+    }
+    int holes = endHole > firstHole ? endHole - firstHole : 0;
+
+    int needed = fullBlocks - oldCount - holes;
+    if (fullBlocks > oldCount) {
+        int startBlock = needed > 0 ? findFreeBlocks(needed) : -1;
+        if (needed > 0 && startBlock == -1) {
+            return -1;
+        }
+        int* map = (int*)realloc(f->block_map, fullBlocks * sizeof(int));
+        if (!map) {
+            perror("Échec de l'agrandissement de la table des blocs");
+            return -1;
+        }
+        f->block_map = map;
+        if (needed > 0) {
+            markBlocks(startBlock, needed, '1');
+        }
+        for (int b = oldCount; b < fullBlocks; ++b) {
+            if (b >= firstHole && b < endHole) {
+                map[b] = -1;  // Trou : lu comme des zéros, aucun bloc
+            } else {
+                g_partitionStatus.block_refs[startBlock] = 1;
+                map[b] = startBlock++;
+            }
+        }
+    }
+
+    // Placer la nouvelle queue avant de rendre l'ancienne
+    file oldTail = *f;
+    f->tail_block = -1;
+    if (tailSize > 0 && allocateTail(f, tailSize) == -1) {
+        for (int b = oldCount; b < fullBlocks; ++b) {
+            if (f->block_map[b] != -1) {
+                releaseBlock(f->block_map[b]);
+            }
+        }
+        f->tail_block = oldTail.tail_block;
+        f->tail_offset = oldTail.tail_offset;
+        f->tail_size = oldTail.tail_size;
+        return -1;
+    }
+    if (tailSize == 0) {
+        f->tail_offset = 0;
+        f->tail_size = 0;
+    }
+    freeTail(&oldTail);
+
+    f->inline_data = 0;
+    f->blocks_count = fullBlocks;
+    f->block_start = fullBlocks > 0 ? f->block_map[0] : -1;
+    return 0;
+}
+
+/**
+ * @brief Réduit l'allocation d'un fichier à une taille plus petite.
+ *
+ * Les blocs pleins au-delà de la nouvelle taille sont rendus et la queue est
+ * replacée ; si aucun bloc de queues n'est disponible, le dernier bloc plein
+ * est gardé à sa place.
+ *
+ * @param f Le pointeur vers la structure de fichier.
+ * @param newSize La nouvelle taille du fichier.
+ */
+static void shrinkBlocks(file* f, int newSize) {
+    int fullBlocks = blockIndex(newSize);
+    int tailSize = blockOffset(newSize);
+    if (tailSize > TAIL_MAX_SIZE) {
+        ++fullBlocks;
+        tailSize = 0;
+    }
+
+    file oldTail = *f;
+    if (tailSize > 0 && f->tail_block != -1 && tailSize <= f->tail_size) {
+        f->tail_size = tailSize;  // La queue tient dans sa place actuelle
+        oldTail.tail_block = -1;
+    } else if (tailSize > 0) {
+        f->tail_block = -1;
+        if (allocateTail(f, tailSize) == -1) {
+            ++fullBlocks;  // Garder le bloc plein qui contient la fin du fichier
+            f->tail_block = -1;
+            f->tail_offset = 0;
+            f->tail_size = 0;
+        }
+    } else {
+        f->tail_block = -1;
+        f->tail_offset = 0;
+        f->tail_size = 0;
+    }
+    freeTail(&oldTail);
+
+    for (int b = fullBlocks; b < f->blocks_count; ++b) {
+        if (f->block_map[b] != -1) {
+            releaseBlock(f->block_map[b]);
+        }
+    }
+    if (fullBlocks < f->blocks_count) {
+        f->blocks_count = fullBlocks;
+        f->block_start = fullBlocks > 0 ? f->block_map[0] : -1;
+    }
+}
+
+/**
+ * @brief Met à jour le partage des blocs pleins touchés par une écriture.
+ *
+ * Un bloc entièrement réécrit dont le contenu existe déjà sur la partition
+ * (même empreinte et mêmes octets) est remplacé par une référence vers ce bloc (si la déduplication est
+ * active). Un bloc partagé modifié reçoit sa propre copie, et un bloc
+ * modifié sort de l'index puisque son empreinte n'est plus valable.
+ *
+ * Seule l'occupation de la partition est partagée : l'écriture des octets
+ * dans le fichier hôte a lieu dans tous les cas.
+ * 
+ * @param f Le pointeur vers la structure de fichier.
+ * @param buffer Les données qui vont être écrites.
+ * @param position La position de l'écriture dans le fichier.
+ * @param nBytes Le nombre d'octets écrits.
+ * @return 0 en cas de réussite, -1 s'il n'y a pas assez d'espace pour les copies.
+ */
+static int updateBlockSharing(file* f, const char* buffer, int position, int nBytes) {
+    int first = blockIndex(position);
+    int last = blockIndex(position + nBytes - 1);
+    if (last >= f->blocks_count) {
+        last = f->blocks_count - 1;  // Le reste est dans la queue
+    }
+
+    // Vérifier qu'il y aura de quoi copier les blocs partagés et remplir les trous
+    int copies = 0;
+    for (int b = first; b <= last; ++b) {
+        int block = f->block_map[b];
+        copies += block == -1 || g_partitionStatus.block_refs[block] > 1;
+    }
+    if (copies > g_partitionStatus.free_blocks) {
+        return -1;
+    }
+
+    for (int b = first; b <= last; ++b) {
+        int block = f->block_map[b];
+        int covered = b * BLOCK_SIZE >= position && (b + 1) * BLOCK_SIZE <= position + nBytes;
+        uint64_t hash = 0;
+
+        if (covered && g_dedupEnabled) {
+            hash = blockHash(buffer + b * BLOCK_SIZE - position, BLOCK_SIZE);
+            int same = dedupLookup(hash, buffer + b * BLOCK_SIZE - position);
+            if (same != -1) {
+                if (same != block) {
+                    g_partitionStatus.block_refs[same]++;  // Partager le bloc existant
+                    if (block != -1) {
+                        releaseBlock(block);
+                    }
+                    f->block_map[b] = same;
+                }
+                continue;
+            }
+        }
+
+        // Contenu nouveau : le bloc ne doit plus être partagé ni indexé
+        if (block == -1) {
+            block = takeFreeBlock();  // Écriture dans un trou
+            f->block_map[b] = block;
+        } else if (g_partitionStatus.block_refs[block] > 1) {
+            g_partitionStatus.block_refs[block]--;
+            block = takeFreeBlock();
+            f->block_map[b] = block;
+        } else if (g_blockContent[block]) {
+            dedupRemove(block);
+        }
+        if (covered && g_dedupEnabled) {
+            dedupInsert(hash, block, buffer + b * BLOCK_SIZE - position);
+        }
+    }
+    f->block_start = f->block_map[0];
+    return 0;
+}
+
+/**
+ * @brief Active ou désactive la déduplication des blocs.
+ * 
+ * @param enabled 1 pour activer, 0 pour désactiver.
+ */
+void setDeduplication(int enabled) {
+    g_dedupEnabled = enabled != 0;
+}
+
+/**
+ * @brief Calcule le taux de déduplication de la partition.
+ * 
+ * @return Le rapport entre blocs référencés et blocs occupés (1.0 sans partage).
+ */
+double getDedupRatio(void) {
+    long logical = 0;
+    long physical = 0;
+    for (int i = 0; i < TOTAL_BLOCKS; ++i) {
+        if (g_partitionStatus.block_usage[i] == '1') {
+            logical += g_partitionStatus.block_refs[i];
+            ++physical;
+        }
+    }
+    return physical > 0 ? (double)logical / physical : 1.0;
+}
+
+/**
+ * @brief Obtient la taille du fichier.
+ * 
+ * @param f Le pointeur vers la structure de fichier.
+ * @return La taille du fichier ou -1 en cas d'erreur.
+ */
+static int fileSize(const file* f) {
+    return f ? f->size : -1;
+}
+
+/**
+ * @brief Formatte la partition.
+ * 
+ * @param partitionName Le nom de la partition à formater.
+ * @return 0 en cas de réussite, -1 en cas d'échec.
+ */
+static int formatPartition(char* partitionName) {
+    FILE *fp = fopen(partitionName, "wb+");
+    if (!fp) {
+        perror("Échec de la création de la partition");
+        return -1;
+    }
+
+    // Image creuse remplie de zéros : aucun espace physique tant qu'aucun bloc n'est écrit
+    if (ftruncate(fileno(fp), PARTITION_SIZE) != 0) {
+        perror("Échec de l'écriture sur la partition");
+        fclose(fp);
+        return -1;
+    }
+
+    fclose(fp);
+
+    // Chemin absolu : le fil de libération ne doit pas dépendre du répertoire courant (myCd)
+    char* resolved = realpath(partitionName, NULL);
+    if (!resolved || strlen(resolved) >= sizeof(g_partitionName)) {
+        fprintf(stderr, "Chemin de la partition introuvable : %s\n", partitionName);
+        free(resolved);
+        return -1;
+    }
+
+    // Oublier les libérations destinées à l'image précédente, après le lot en cours
+    pthread_mutex_lock(&g_discardLock);
+    while (g_discardBusy) {
+        pthread_cond_wait(&g_discardDone, &g_discardLock);
+    }
+    memset(g_discardPending, 0, sizeof(g_discardPending));
+    atomic_store(&g_discardCount, 0);
+    strcpy(g_partitionName, resolved);
+    pthread_mutex_unlock(&g_discardLock);
+    free(resolved);
+
+    initializePartitionStatus();  // Partition vierge : tous les blocs sont libres
+    return 0;
+}
+
+/**
+ * @brief Active ou désactive la compression des nouveaux fichiers.
+ * 
+ * @param enabled 1 pour activer, 0 pour désactiver.
+ */
+void setCompression(int enabled) {
+    g_compressionEnabled = enabled != 0;
+}
+
+/**
+ * @brief Libère l'état de compression d'un fichier.
+ * 
+ * @param c L'état de compression (peut être NULL).
+ */
+static void freeCompressionState(CompressionState* c) {
+    if (c) {
+        free(c->chunks);
+        free(c->cache);
+        free(c);
+    }
+}
+
+/**
+ * @brief Crée un état de compression vide.
+ * 
+ * @return L'état alloué ou NULL en cas d'échec.
+ */
+static CompressionState* newCompressionState(void) {
+    CompressionState* c = (CompressionState*)calloc(1, sizeof(CompressionState));
+    if (c) {
+        c->cache = (char*)malloc(COMPRESS_CHUNK_SIZE);
+        c->cached_chunk = -1;
+        if (!c->cache) {
+            free(c);
+            c = NULL;
+        }
+    }
+    if (!c) {
+        perror("Échec de l'allocation de l'état de compression");
+    }
+    return c;
+}
+
+/**
+ * @brief Écrit la table des morceaux puis l'en-tête qui la désigne.
+ *
+ * L'en-tête est écrit en dernier : tant qu'il n'est pas à jour, le fichier
+ * reste lisible dans sa version précédente.
+ * 
+ * @param f Le pointeur vers la structure de fichier.
+ * @param fp Le fichier hôte ouvert en écriture.
+ * @param mapOffset La position de la table dans le fichier.
+ * @return 0 en cas de réussite, -1 en cas d'échec.
+ */
+static int writeCompressedMeta(file* f, FILE* fp, int mapOffset) {
+    CompressionState* c = f->compression;
+    CompressedHeader header;
+    memcpy(header.magic, COMPRESS_MAGIC, sizeof(header.magic));
+    header.version = COMPRESS_VERSION;
+    header.flags = 0;
+    header.size = f->size;
+    header.chunks = c->chunks_count;
+    header.map_offset = mapOffset;
+
+    if (fseek(fp, mapOffset, SEEK_SET) != 0 ||
+        fwrite(c->chunks, sizeof(ChunkEntry), c->chunks_count, fp) < (size_t)c->chunks_count ||
+        fseek(fp, 0, SEEK_SET) != 0 ||
+        fwrite(&header, sizeof(header), 1, fp) < 1 ||
+        fflush(fp) != 0) {
+        perror("Échec de l'écriture de la table des morceaux");
+        return -1;
+    }
+    c->file_end = mapOffset + c->chunks_count * sizeof(ChunkEntry);
+    return 0;
+}
+
+/**
+ * @brief Refuse l'en-tête d'un fichier qui n'est peut-être pas compressé.
+ * 
+ * @param f Le pointeur vers la structure de fichier.
+ * @param known 1 si le fichier est connu comme compressé.
+ * @param reason La raison du refus.
+ * @return -1 si le fichier est connu comme compressé, 0 s'il est à lire comme un fichier ordinaire.
+ */
+static int rejectCompressed(const file* f, int known, const char* reason) {
+    if (!known) {
+        return 0;
+    }
+    fprintf(stderr, "%s dans %s.\n", reason, f->name);
+    return -1;
+}
+
+/**
+ * @brief Charge l'état d'un fichier compressé existant.
+ *
+ * L'en-tête et la table des morceaux sont vérifiés contre la taille du
+ * fichier hôte avant d'être utilisés. Un fichier que la table des noms ne
+ * connaît pas (partition reformatée, programme relancé) n'est reconnu que
+ * si tout l'en-tête est valide : un fichier ordinaire qui commence par la
+ * signature reste ordinaire.
+ * 
+ * @param f Le pointeur vers la structure de fichier (taille physique dans f->size).
+ * @param fp Le fichier hôte ouvert.
+ * @param known 1 si le fichier est connu comme compressé.
+ * @return 1 en cas de réussite, 0 si le fichier n'est pas compressé, -1 si
+ *         un fichier connu comme compressé est illisible ou corrompu.
+ */
+static int openCompressed(file* f, FILE* fp, int known) {
+    CompressedHeader header;
+    uint32_t hostSize = f->size;
+    if (hostSize < sizeof(header) || fread(&header, sizeof(header), 1, fp) < 1 ||
+        memcmp(header.magic, COMPRESS_MAGIC, sizeof(header.magic)) != 0) {
+        return rejectCompressed(f, known, "En-tête compressé absent");
+    }
+    if (header.version != COMPRESS_VERSION || header.flags != 0) {
+        return rejectCompressed(f, known, "Version de compression non prise en charge");
+    }
+    if (header.map_offset < sizeof(header) || header.map_offset > hostSize ||
+        header.chunks > (hostSize - header.map_offset) / sizeof(ChunkEntry) ||
+        header.size > (uint64_t)header.chunks * COMPRESS_CHUNK_SIZE) {
+        return rejectCompressed(f, known, "En-tête compressé corrompu");
+    }
+
+    CompressionState* c = newCompressionState();
+    if (!c) {
+        return -1;
+    }
+    c->chunks_count = header.chunks;
+    c->chunks = (ChunkEntry*)calloc(header.chunks + 1, sizeof(ChunkEntry));
+    if (!c->chunks || fseek(fp, header.map_offset, SEEK_SET) != 0 ||
+        fread(c->chunks, sizeof(ChunkEntry), header.chunks, fp) < header.chunks) {
+        freeCompressionState(c);
+        return rejectCompressed(f, known, "Table des morceaux illisible");
+    }
+
+    // Chaque morceau doit tenir entre l'en-tête et la table
+    uint64_t live = 0;
+    for (int i = 0; i < c->chunks_count; ++i) {
+        ChunkEntry entry = c->chunks[i];
+        uint32_t stored = entry.length & ~CHUNK_RAW;
+        if (entry.offset == 0 ? entry.length != 0
+                              : entry.offset < sizeof(header) || stored > COMPRESS_CHUNK_BOUND ||
+                                (uint64_t)entry.offset + stored > header.map_offset) {
+            freeCompressionState(c);
+            return rejectCompressed(f, known, "Table des morceaux corrompue");
+        }
+        live += stored;
+    }
+    if (live > header.map_offset - sizeof(header)) {
+        freeCompressionState(c);
+        return rejectCompressed(f, known, "Table des morceaux corrompue");
+    }
+
+    c->live_bytes = (int)live;
+    c->file_end = header.map_offset + header.chunks * sizeof(ChunkEntry);
+    c->dead_bytes = header.map_offset - (int)sizeof(header) - c->live_bytes;
+    if (!known && markCompressed(f->name, 1) == -1) {
+        freeCompressionState(c);
+        return -1;
+    }
+    f->compression = c;
+    f->size = header.size;
+    return 1;
+}
+
+/**
+ * @brief Transforme un fichier vide en fichier compressé.
+ * 
+ * @param f Le pointeur vers la structure de fichier.
+ * @param fp Le fichier hôte ouvert en écriture.
+ * @return 1 en cas de réussite, -1 en cas d'échec.
+ */
+static int createCompressed(file* f, FILE* fp) {
+    f->compression = newCompressionState();
+    if (!f->compression || writeCompressedMeta(f, fp, sizeof(CompressedHeader)) == -1 ||
+        markCompressed(f->name, 1) == -1) {
+        freeCompressionState(f->compression);
+        f->compression = NULL;
+        return -1;
+    }
+    return 1;
+}
+
+/**
+ * @brief Décompresse un morceau du fichier.
+ * 
+ * @param f Le pointeur vers la structure de fichier.
+ * @param fp Le fichier hôte ouvert en lecture.
+ * @param index L'index du morceau.
+ * @param out Le tampon de COMPRESS_CHUNK_SIZE octets à remplir.
+ * @return 0 en cas de réussite, -1 en cas d'échec.
+ */
+static int loadChunk(file* f, FILE* fp, int index, char* out) {
+    CompressionState* c = f->compression;
+    if (index >= c->chunks_count || c->chunks[index].offset == 0) {
+        g_blockKernels->zero_blocks(out, COMPRESS_CHUNK_SIZE);  // Morceau jamais écrit
+        return 0;
+    }
+
+    ChunkEntry entry = c->chunks[index];
+    int stored = entry.length & ~CHUNK_RAW;
+    if (stored > COMPRESS_CHUNK_BOUND || fseek(fp, entry.offset, SEEK_SET) != 0) {
+        perror("Échec de la lecture d'un morceau compressé");
+        return -1;
+    }
+    if (entry.length & CHUNK_RAW) {
+        if (fread(out, 1, stored, fp) < (size_t)stored) {
+            perror("Échec de la lecture d'un morceau compressé");
+            return -1;
+        }
+        memset(out + stored, 0, COMPRESS_CHUNK_SIZE - stored);
+        return 0;
+    }
+
+    // Tampon sur le tas : un morceau compressé peut dépasser la taille de la pile
+    char* packed = (char*)malloc(stored + 1);
+    if (!packed || fread(packed, 1, stored, fp) < (size_t)stored) {
+        perror("Échec de la lecture d'un morceau compressé");
+        free(packed);
+        return -1;
+    }
+    int length = lzDecompress(packed, stored, out, COMPRESS_CHUNK_SIZE);
+    free(packed);
+    if (length < 0) {
+        fprintf(stderr, "Morceau compressé corrompu dans %s.\n", f->name);
+        return -1;
+    }
+    memset(out + length, 0, COMPRESS_CHUNK_SIZE - length);
+    return 0;
+}
+
+/**
+ * @brief Récompacte un fichier compressé en éliminant les anciennes versions.
+ *
+ * La version compacte est écrite dans un fichier temporaire qui remplace
+ * l'original par rename : une interruption laisse l'une ou l'autre version
+ * entière, jamais un mélange des deux. Les blocs réservés au-delà de la
+ * nouvelle taille physique sont rendus à la partition.
+ * 
+ * @param f Le pointeur vers la structure de fichier.
+ * @param fp Le fichier hôte ouvert en lecture.
+ * @return 0 en cas de réussite, -1 en cas d'échec.
+ */
+static int compactCompressed(file* f, FILE* fp) {
+    CompressionState* c = f->compression;
+    char* live = (char*)malloc(c->live_bytes + 1);
+    ChunkEntry* moved = (ChunkEntry*)malloc((c->chunks_count + 1) * sizeof(ChunkEntry));
+    char* tempName = (char*)malloc(strlen(f->name) + sizeof(".compact"));
+    if (!live || !moved || !tempName) {
+        free(live);
+        free(moved);
+        free(tempName);
+        return -1;  // Le fichier reste valide, simplement moins compact
+    }
+
+    int used = 0;
+    for (int i = 0; i < c->chunks_count; ++i) {
+        int stored = c->chunks[i].length & ~CHUNK_RAW;
+        moved[i] = c->chunks[i];
+        if (c->chunks[i].offset == 0) {
+            continue;
+        }
+        if (fseek(fp, c->chunks[i].offset, SEEK_SET) != 0 ||
+            fread(live + used, 1, stored, fp) < (size_t)stored) {
+            free(live);
+            free(moved);
+            free(tempName);
+            return -1;
+        }
+        moved[i].offset = sizeof(CompressedHeader) + used;
+        used += stored;
+    }
+
+    // Écrire la nouvelle version à côté, avec sa table et son en-tête
+    sprintf(tempName, "%s.compact", f->name);
+    ChunkEntry* chunks = c->chunks;
+    int fileEnd = c->file_end;
+    c->chunks = moved;
+    FILE* out = fopen(tempName, "wb");
+    int written = out && fseek(out, sizeof(CompressedHeader), SEEK_SET) == 0 &&
+                  fwrite(live, 1, used, out) == (size_t)used &&
+                  writeCompressedMeta(f, out, sizeof(CompressedHeader) + used) == 0 &&
+                  fsync(fileno(out)) == 0;
+    if (out && fclose(out) != 0) {
+        written = 0;
+    }
+
+    int status = -1;
+    if (written && rename(tempName, f->name) == 0) {
+        free(chunks);
+        c->dead_bytes = 0;
+        if (c->file_end < c->accounted) {
+            shrinkBlocks(f, c->file_end);
+            c->accounted = c->file_end;
+        }
+        status = 0;
+    } else {
+        perror("Échec du récompactage du fichier compressé");
+        c->chunks = chunks;  // L'original est intact : revenir à sa table
+        c->file_end = fileEnd;
+        free(moved);
+        remove(tempName);
+    }
+    free(live);
+    free(tempName);
+    return status;
+}
+
+/**
+ * @brief Lit depuis un fichier compressé en ne décompressant que les morceaux touchés.
+ * 
+ * @param f Le pointeur vers la structure de fichier.
+ * @param buffer Le tampon où stocker les données lues.
+ * @param nBytes Le nombre d'octets à lire.
+ * @return Le nombre d'octets lus ou -1 en cas d'erreur.
+ */
+static int compressedRead(file* f, void* buffer, int nBytes) {
+    CompressionState* c = f->compression;
+    int bytesRead = f->size - f->current_position;
+    if (bytesRead > nBytes) {
+        bytesRead = nBytes;
+    }
+    if (bytesRead <= 0) {
+        printf("Fin du fichier atteinte.\n");
+        return 0;
+    }
+
+    FILE *fp = fopen(f->name, "rb");
+    if (!fp) {
+        perror("Échec de l'ouverture du fichier pour lecture");
+        return -1;
+    }
+
+    char* out = (char*)buffer;
+    int position = f->current_position;
+    int remaining = bytesRead;
+    while (remaining > 0) {
+        int index = position / COMPRESS_CHUNK_SIZE;
+        int offset = position % COMPRESS_CHUNK_SIZE;
+        int n = COMPRESS_CHUNK_SIZE - offset;
+        if (n > remaining) {
+            n = remaining;
+        }
+        if (c->cached_chunk != index) {
+            c->cached_chunk = -1;
+            if (loadChunk(f, fp, index, c->cache) == -1) {
+                fclose(fp);
+                return -1;
+            }
+            c->cached_chunk = index;
+        }
+        memcpy(out, c->cache + offset, n);
+        out += n;
+        position += n;
+        remaining -= n;
+    }
+
+    fclose(fp);
+    f->current_position = position;
+    return bytesRead;
 }
 
 /**
- * @brief Formatte la partition.
+ * @brief Écrit dans un fichier compressé.
+ *
+ * Chaque morceau touché est recompressé et ajouté à la fin du fichier, suivi
+ * de la nouvelle table ; l'en-tête est mis à jour en dernier. Les anciennes
+ * versions sont récupérées quand elles occupent plus que les données vivantes,
+ * ou quand leur place manque sur la partition.
  * 
- * @param partitionName Le nom de la partition à formater.
- * @return 0 en cas de réussite, -1 en cas d'échec.
+ * @param f Le pointeur vers la structure de fichier.
+ * @param buffer Le tampon contenant les données à écrire.
+ * @param nBytes Le nombre d'octets à écrire.
+ * @return Le nombre d'octets écrits ou -1 en cas d'erreur.
  */
-int myFormat(char* partitionName) {
-    FILE *fp = fopen(partitionName, "wb+");
+static int compressedWrite(file* f, const void* buffer, int nBytes) {
+    CompressionState* c = f->compression;
+    const char* src = (const char*)buffer;
+    int position = f->current_position;
+    int newSize = position + nBytes > f->size ? position + nBytes : f->size;
+    int first = position / COMPRESS_CHUNK_SIZE;
+    int last = (position + nBytes - 1) / COMPRESS_CHUNK_SIZE;
+    int touched = last - first + 1;
+
+    FILE *fp = fopen(f->name, "rb+");
     if (!fp) {
-        perror("Échec de la création de la partition");
+        perror("Échec de l'ouverture du fichier pour écriture");
         return -1;
     }
 
-    // Initialiser la partition avec des zéros
-    char buffer[PARTITION_SIZE];
-    memset(buffer, 0, PARTITION_SIZE);
-    if (fwrite(buffer, 1, PARTITION_SIZE, fp) < PARTITION_SIZE) {
-        perror("Échec de l'écriture sur la partition");
+    char* packed = (char*)malloc((size_t)touched * COMPRESS_CHUNK_BOUND);
+    uint32_t* lengths = (uint32_t*)malloc(touched * sizeof(uint32_t));
+    char* work = (char*)malloc(COMPRESS_CHUNK_SIZE);
+    int used = 0;
+    int status = -1;
+    if (!packed || !lengths || !work) {
+        perror("Échec de l'allocation du tampon de compression");
+        goto done;
+    }
+
+    // Recompresser chaque morceau touché en mémoire
+    for (int i = 0; i < touched; ++i) {
+        int index = first + i;
+        int start = index * COMPRESS_CHUNK_SIZE;
+        if (index == c->cached_chunk) {
+            g_blockKernels->copy_blocks(work, c->cache, COMPRESS_CHUNK_SIZE);
+        } else if (loadChunk(f, fp, index, work) == -1) {
+            goto done;
+        }
+
+        int from = position > start ? position : start;
+        int to = position + nBytes < start + COMPRESS_CHUNK_SIZE ? position + nBytes : start + COMPRESS_CHUNK_SIZE;
+        memcpy(work + (from - start), src + (from - position), to - from);
+
+        int chunkLength = newSize - start < COMPRESS_CHUNK_SIZE ? newSize - start : COMPRESS_CHUNK_SIZE;
+        int stored = lzCompress(work, chunkLength, packed + used, COMPRESS_CHUNK_BOUND);
+        if (stored == 0 || stored >= chunkLength) {
+            memcpy(packed + used, work, chunkLength);  // Incompressible : stocké tel quel
+            stored = chunkLength;
+            lengths[i] = stored | CHUNK_RAW;
+        } else {
+            lengths[i] = stored;
+        }
+        used += stored;
+    }
+
+    // Réserver la place sur la partition avant de toucher au fichier
+    int newCount = last + 1 > c->chunks_count ? last + 1 : c->chunks_count;
+    int mapOffset = c->file_end + used;
+    int physicalSize = mapOffset + newCount * sizeof(ChunkEntry);
+    int reserved = physicalSize <= c->accounted || growBlocks(f, physicalSize, 0) == 0;
+    if (!reserved && c->dead_bytes > 0 && compactCompressed(f, fp) == 0) {
+        // Les anciennes versions occupaient la place qui manque : réessayer sans elles
         fclose(fp);
-        return -1;
+        fp = fopen(f->name, "rb+");
+        if (!fp) {
+            perror("Échec de l'ouverture du fichier pour écriture");
+            goto done;
+        }
+        mapOffset = c->file_end + used;
+        physicalSize = mapOffset + newCount * sizeof(ChunkEntry);
+        reserved = physicalSize <= c->accounted || growBlocks(f, physicalSize, 0) == 0;
+    }
+    if (!reserved) {
+        fprintf(stderr, "Espace insuffisant sur la partition.\n");
+        if (g_statsEnabled) statsAllocFailure(OP_WRITE);
+        goto done;
+    }
+    if (physicalSize > c->accounted) {
+        c->accounted = physicalSize;
     }
 
-    fclose(fp);
-    return 0;
+    if (fseek(fp, c->file_end, SEEK_SET) != 0 || fwrite(packed, 1, used, fp) < (size_t)used) {
+        perror("Échec de l'écriture des données dans le fichier");
+        goto done;
+    }
+
+    if (newCount > c->chunks_count) {
+        ChunkEntry* chunks = (ChunkEntry*)realloc(c->chunks, newCount * sizeof(ChunkEntry));
+        if (!chunks) {
+            perror("Échec de l'agrandissement de la table des morceaux");
+            goto done;
+        }
+        memset(chunks + c->chunks_count, 0, (newCount - c->chunks_count) * sizeof(ChunkEntry));
+        c->chunks = chunks;
+    }
+
+    // L'ancienne table et les anciennes versions des morceaux deviennent inutiles
+    c->dead_bytes += c->chunks_count * sizeof(ChunkEntry);
+    int offset = c->file_end;
+    for (int i = 0; i < touched; ++i) {
+        ChunkEntry* entry = &c->chunks[first + i];
+        if (entry->offset != 0) {
+            int old = entry->length & ~CHUNK_RAW;
+            c->dead_bytes += old;
+            c->live_bytes -= old;
+        }
+        entry->offset = offset;
+        entry->length = lengths[i];
+        offset += lengths[i] & ~CHUNK_RAW;
+        c->live_bytes += lengths[i] & ~CHUNK_RAW;
+    }
+    c->chunks_count = newCount;
+    f->size = newSize;
+    if (writeCompressedMeta(f, fp, mapOffset) == -1) {
+        goto done;
+    }
+
+    // Le dernier morceau écrit reste en cache pour les écritures suivantes
+    g_blockKernels->copy_blocks(c->cache, work, COMPRESS_CHUNK_SIZE);
+    c->cached_chunk = last;
+
+    if (c->dead_bytes > c->live_bytes && c->dead_bytes > COMPRESS_CHUNK_SIZE) {
+        compactCompressed(f, fp);
+    }
+    f->current_position += nBytes;
+    status = nBytes;
+
+done:
+    free(packed);
+    free(lengths);
+    free(work);
+    if (fp) {
+        fclose(fp);
+    }
+    return status;
 }
 
 /**
@@ -150,7 +1831,7 @@ int myFormat(char* partitionName) {
  * @param fileName Le nom du fichier à ouvrir.
  * @return Un pointeur vers la structure de fichier ou NULL en cas d'échec.
  */
-file* myOpen(char* fileName) {
+static file* openFile(char* fileName) {
     file *f = (file*)malloc(sizeof(file));
     if (!f) {
         perror("Échec de l'allocation de la structure de fichier");
@@ -161,6 +1842,14 @@ file* myOpen(char* fileName) {
     f->size = 0;
     f->current_position = 0;
     f->data = NULL;
+    f->compression = NULL;
+    f->trace_id = atomic_fetch_add(&g_nextTraceId, 1) + 1;
+    f->block_start = -1;
+    f->blocks_count = 0;
+    f->block_map = NULL;
+    f->tail_block = -1;
+    f->tail_offset = 0;
+    f->tail_size = 0;
 
     FILE *fp = fopen(fileName, "rb");
     if (!fp) {
@@ -187,8 +1876,32 @@ file* myOpen(char* fileName) {
 
     fseek(fp, 0, SEEK_END);
     f->size = ftell(fp);
+    int hostSize = f->size;
     rewind(fp);
+
+    // Fichier compressé : seule la table des morceaux est chargée
+    int compressed = openCompressed(f, fp, isCompressed(f->name));
+    if (compressed == 0) {
+        rewind(fp);
+    }
+    if (compressed == 0 && g_compressionEnabled && f->size == 0) {
+        compressed = createCompressed(f, fp);
+    }
+    if (compressed != 0) {
+        fclose(fp);
+        if (compressed == -1) {
+            free(f->name);
+            free(f);
+            return NULL;
+        }
+        f->inline_data = 0;
+        adoptClosed(f, hostSize);
+        return f;
+    }
+    adoptClosed(f, hostSize);
     
+    // Un petit fichier n'occupe aucun bloc de la partition
+    f->inline_data = f->size <= INLINE_DATA_SIZE;
     f->data = (char*)malloc(f->size + 1);
     if (f->data) {
         fread(f->data, f->size, 1, fp);
@@ -207,23 +1920,36 @@ file* myOpen(char* fileName) {
  * @param nBytes Le nombre d'octets à écrire.
  * @return Le nombre d'octets écrits ou -1 en cas d'erreur.
  */
-int myWrite(file* f, void* buffer, int nBytes) {
+static int writeFile(file* f, void* buffer, int nBytes) {
     if (!f || !buffer || nBytes < 1) {
         fprintf(stderr, "Paramètres non valides pour myWrite.\n");
         return -1;
     }
     
+    if (f->compression) {
+        return compressedWrite(f, buffer, nBytes);
+    }
+
+    // Réserver l'espace sur la partition si le fichier grandit
+    int newSize = f->current_position + nBytes;
+    if ((newSize > f->size && growBlocks(f, newSize, f->current_position) == -1) ||
+        (f->blocks_count > 0 && updateBlockSharing(f, buffer, f->current_position, nBytes) == -1)) {
+        fprintf(stderr, "Espace insuffisant sur la partition.\n");
+        if (g_statsEnabled) statsAllocFailure(OP_WRITE);
+        return -1;
+    }
+
     FILE *fp = fopen(f->name, "rb+");
     if (!fp) {
         perror("Échec de l'ouverture du fichier pour écriture");
         return -1;
     }
-    
+
     fseek(fp, f->current_position, SEEK_SET);
     int bytesWritten = fwrite(buffer, 1, nBytes, fp);
+    fclose(fp);
     if (bytesWritten < nBytes) {
         perror("Échec de l'écriture des données dans le fichier");
-        fclose(fp);
         return -1;
     }
 
@@ -232,7 +1958,6 @@ int myWrite(file* f, void* buffer, int nBytes) {
         f->size = f->current_position;
     }
 
-    fclose(fp);
     return bytesWritten;
 }
 
@@ -244,20 +1969,25 @@ int myWrite(file* f, void* buffer, int nBytes) {
  * @param nBytes Le nombre d'octets à lire.
  * @return Le nombre d'octets lus ou -1 en cas d'erreur.
  */
-int myRead(file* f, void* buffer, int nBytes) {
+static int readFile(file* f, void* buffer, int nBytes) {
     if (!f || !buffer || nBytes < 1) {
         fprintf(stderr, "Paramètres non valides pour myRead ou à la fin du fichier.\n");
         return -1;
     }
 
+    memset(buffer, 0, nBytes);
+
+    if (f->compression) {
+        return compressedRead(f, buffer, nBytes);
+    }
+
+    // Même un petit fichier est relu sur l'hôte : un autre descripteur a pu l'écrire
     FILE *fp = fopen(f->name, "rb");
     if (!fp) {
         perror("Échec de l'ouverture du fichier pour lecture");
         return -1;
     }
 
-    memset(buffer, 0, nBytes);
-
     if (fseek(fp, f->current_position, SEEK_SET) != 0) {
         perror("Échec de la recherche de la position actuelle dans le fichier");
         fclose(fp);
@@ -286,7 +2016,7 @@ int myRead(file* f, void* buffer, int nBytes) {
  * @param offset Le décalage par rapport à la position de base.
  * @param base La position de base à partir de laquelle effectuer le décalage.
  */
-void mySeek(file* f, int offset, int base) {
+static void seekFile(file* f, int offset, int base) {
     if (!f) {
         perror("Structure de fichier invalide");
         return;
@@ -315,11 +2045,8 @@ void mySeek(file* f, int offset, int base) {
         new_position = 0;
     }
 
-    // S'assurer également que la nouvelle position n'est pas au-delà de la fin du fichier.
-    if (new_position > f->size) {
-        perror("La position de recherche est au-delà de la fin du fichier");
-        new_position = f->size;
-    }
+    // Une position au-delà de la fin est permise : la prochaine écriture y
+    // laissera un trou, lu comme des zéros et sans bloc alloué.
 
     // Définir la position actuelle du fichier sur la nouvelle position.
     f->current_position = new_position;
@@ -361,14 +2088,16 @@ int myCd(char **params) {
  * 
  * @param f Le pointeur vers la structure de fichier à supprimer.
  */
-void myDelete(file* f) {
+static void deleteFile(file* f) {
     if (!f) {
         printf("Fichier invalide.\n");
         return;
     }
 
-    // Libérer les blocs de disque occupés par le fichier
-    freeBlocks(f);
+    // Libérer les blocs de disque occupés par le fichier (et ceux d'un autre descripteur fermé)
+    freeFileBlocks(f);
+    dropClosed(f->name);
+    markCompressed(f->name, 0);
     
     // Supprimer les fichiers du système de fichiers
     if (remove(f->name) == 0) {
@@ -380,38 +2109,130 @@ void myDelete(file* f) {
     // Libérer la mémoire occupée par la structure de fichier
     free(f->name);
     free(f->data);
+    freeCompressionState(f->compression);
+    free(f);
+}
+
+/**
+ * @brief Ferme un fichier sans le supprimer.
+ *
+ * Ses blocs restent réservés sur la partition et sont repris par la
+ * prochaine ouverture du même nom.
+ * 
+ * @param f Le pointeur vers la structure de fichier à libérer.
+ */
+static void closeFile(file* f) {
+    if (!f) {
+        return;
+    }
+    keepClosed(f);
+    free(f->name);
+    free(f->data);
+    freeCompressionState(f->compression);
     free(f);
 }
 
+#define COPY_BUFFER_BLOCKS 16 /**< Blocs lus puis écrits à la fois par copyFile */
+
+/**
+ * @brief Réserve sur la partition les blocs de la copie d'un fichier.
+ *
+ * Un fichier ordinaire passe par le même chemin qu'une écriture : ses blocs
+ * pleins partent comme des trous que updateBlockSharing remplit au fil de la
+ * copie, en partageant les blocs identiques si la déduplication est active.
+ * Un fichier compressé est réservé d'un seul tenant, comme par compressedWrite.
+ * 
+ * @param dest La structure qui décrit la copie (nom renseigné, aucun bloc).
+ * @param size La taille du fichier hôte source.
+ * @param compressed 1 si la source est un fichier compressé.
+ * @return 0 en cas de réussite, -1 s'il n'y a pas assez d'espace.
+ */
+static int reserveCopy(file* dest, int size, int compressed) {
+    dest->inline_data = 1;
+    dest->tail_block = -1;
+    if (compressed) {
+        return growBlocks(dest, size, 0);
+    }
+    if (blockIndex(size) > g_partitionStatus.free_blocks) {
+        return -1;  // Les trous ne pourraient pas tous être remplis
+    }
+    return growBlocks(dest, size, size);
+}
+
 /**
  * @brief Copie un fichier source dans un fichier destination.
+ *
+ * La copie occupe ses propres blocs sur la partition, gardés comme ceux
+ * d'un fichier fermé ; ses blocs identiques à des blocs existants sont
+ * partagés si la déduplication est active.
  * 
  * @param sourceName Le nom du fichier source.
  * @param destName Le nom du fichier destination.
+ * @param copied Reçoit le nombre d'octets copiés (peut être NULL).
  * @return 0 en cas de succès, -1 en cas d'échec.
  */
-int myCopy(const char* sourceName, const char* destName) {
+static int copyFile(const char* sourceName, const char* destName, long long* copied) {
     FILE *sourceFile = fopen(sourceName, "rb");
     if (!sourceFile) {
         perror("Échec de l'ouverture du fichier source pour la copie");
         return -1;
     }
 
-    FILE *destFile = fopen(destName, "wb");
+    int compressed = isCompressed(sourceName);
+    file dest;
+    memset(&dest, 0, sizeof(dest));
+    dest.name = (char*)destName;
+    fseek(sourceFile, 0, SEEK_END);
+    int size = ftell(sourceFile);
+    rewind(sourceFile);
+    if (reserveCopy(&dest, size, compressed) == -1) {
+        fprintf(stderr, "Espace insuffisant sur la partition.\n");
+        if (g_statsEnabled) statsAllocFailure(OP_COPY);
+        fclose(sourceFile);
+        return -1;
+    }
+
+    char* buffer = (char*)malloc(COPY_BUFFER_BLOCKS * BLOCK_SIZE);
+    FILE *destFile = buffer ? fopen(destName, "wb") : NULL;
     if (!destFile) {
         perror("Échec de l'ouverture du fichier destination pour la copie");
+        freeFileBlocks(&dest);
+        free(buffer);
         fclose(sourceFile);
         return -1;
     }
 
-    char buffer[1024];
     size_t bytesRead;
-    while ((bytesRead = fread(buffer, 1, sizeof(buffer), sourceFile)) > 0) {
+    long long total = 0;
+    int status = 0;
+    while ((bytesRead = fread(buffer, 1, COPY_BUFFER_BLOCKS * BLOCK_SIZE, sourceFile)) > 0) {
+        if (!compressed && dest.blocks_count > 0 &&
+            updateBlockSharing(&dest, buffer, (int)total, (int)bytesRead) == -1) {
+            fprintf(stderr, "Espace insuffisant sur la partition.\n");
+            status = -1;
+            break;
+        }
         fwrite(buffer, 1, bytesRead, destFile);
+        total += bytesRead;
+    }
+    if (copied) {
+        *copied = total;
     }
 
+    free(buffer);
     fclose(sourceFile);
     fclose(destFile);
+    if (status == -1) {
+        freeFileBlocks(&dest);
+        return -1;
+    }
+    // Les blocs de la copie remplacent ceux qui décrivaient l'ancien contenu
+    CompressionState state;
+    memset(&state, 0, sizeof(state));
+    state.accounted = size;
+    dest.compression = compressed ? &state : NULL;
+    keepClosed(&dest);
+    markCompressed(destName, compressed);
     return 0;
 }
 
@@ -422,11 +2243,13 @@ int myCopy(const char* sourceName, const char* destName) {
  * @param newName Le nouveau nom du fichier.
  * @return 0 en cas de succès, -1 en cas d'échec.
  */
-int myRename(const char* oldName, const char* newName) {
+static int renameFile(const char* oldName, const char* newName) {
     if (rename(oldName, newName) != 0) {
         perror("Échec du renommage du fichier");
         return -1;
     }
+    renameClosed(oldName, newName);
+    renameCompressed(oldName, newName);
     return 0;
 }
 
@@ -437,9 +2260,11 @@ int myRename(const char* oldName, const char* newName) {
  * @param destName Le nom du fichier destination.
  * @return 0 en cas de succès, -1 en cas d'échec.
  */
-int myMove(const char* sourceName, const char* destName) {
+static int moveFile(const char* sourceName, const char* destName) {
     // Essayer de renommer le fichier directement
     if (rename(sourceName, destName) == 0) {
+        renameClosed(sourceName, destName);
+        renameCompressed(sourceName, destName);
         printf("Fichier '%s' déplacé vers '%s' avec succès.\n", sourceName, destName);
         return 0;
     } else {
@@ -447,8 +2272,10 @@ int myMove(const char* sourceName, const char* destName) {
     }
 
     // Si le renommage échoue, copier puis supprimer le fichier d'origine
-    if (myCopy(sourceName, destName) == 0) {
+    if (copyFile(sourceName, destName, NULL) == 0) {
         if (remove(sourceName) == 0) {
+            dropClosed(sourceName);  // La copie a déjà ses propres blocs
+            markCompressed(sourceName, 0);
             printf("Fichier '%s' copié vers '%s' puis l'original a été supprimé avec succès.\n", sourceName, destName);
             return 0;
         } else {
@@ -469,3 +2296,255 @@ int myExit(char **params) {
     printf("Programme terminé.\n");
     exit(0);
 }
+
+/*
+ * Points d'entrée publics : chacun appelle l'implémentation ci-dessus et,
+ * si les statistiques ou la trace sont actives, mesure ou enregistre
+ * l'appel. Sinon ils ne coûtent qu'un test prévisible.
+ */
+
+/** Vrai si un appel doit être mesuré ou enregistré. */
+#define INSTRUMENTED() __builtin_expect(g_statsEnabled | g_traceEnabled, 0)
+
+/**
+ * @brief Transmet un appel terminé aux statistiques et à la trace.
+ */
+static void recordCall(OpKind op, long long start, int failed, long long bytes, int handle,
+                       long long arg0, long long arg1, long long result,
+                       const char* name0, const char* name1) {
+    if (g_statsEnabled) {
+        statsRecord(op, start, failed, bytes);
+    }
+    if (g_traceEnabled) {
+        traceRecord(op, start, failed, handle, arg0, arg1, result, name0, name1);
+    }
+}
+
+/**
+ * @brief Alloue des blocs pour le fichier.
+ *
+ * Les opérations sur les blocs sont mesurées mais pas tracées : la relecture
+ * les reproduit à travers les appels sur les fichiers.
+ * 
+ * @param f Le pointeur vers la structure de fichier.
+ * @param size La taille du fichier à allouer.
+ * @return Le nombre de blocs alloués ou -1 s'il n'y a pas assez d'espace.
+ */
+int allocateBlocks(file* f, int size) {
+    if (__builtin_expect(!g_statsEnabled, 1)) {
+        return allocateFileBlocks(f, size);
+    }
+    long long start = statsNow();
+    int result = allocateFileBlocks(f, size);
+    if (result == -1) {
+        statsAllocFailure(OP_ALLOCATE);
+    }
+    statsRecord(OP_ALLOCATE, start, result == -1, 0);
+    return result;
+}
+
+/**
+ * @brief Libère les blocs alloués au fichier.
+ * 
+ * @param f Le pointeur vers la structure de fichier.
+ */
+void freeBlocks(file* f) {
+    if (__builtin_expect(!g_statsEnabled, 1)) {
+        freeFileBlocks(f);
+        return;
+    }
+    long long start = statsNow();
+    freeFileBlocks(f);
+    statsRecord(OP_FREE, start, 0, 0);
+}
+
+/**
+ * @brief Obtient la taille du fichier.
+ * 
+ * @param f Le pointeur vers la structure de fichier.
+ * @return La taille du fichier ou -1 en cas d'erreur.
+ */
+int getFileSize(const file* f) {
+    if (!INSTRUMENTED()) {
+        return fileSize(f);
+    }
+    long long start = statsNow();
+    int result = fileSize(f);
+    recordCall(OP_SIZE, start, result == -1, 0, f ? f->trace_id : 0, 0, 0, result, NULL, NULL);
+    return result;
+}
+
+/**
+ * @brief Formatte la partition.
+ * 
+ * @param partitionName Le nom de la partition à formater.
+ * @return 0 en cas de réussite, -1 en cas d'échec.
+ */
+int myFormat(char* partitionName) {
+    if (!INSTRUMENTED()) {
+        return formatPartition(partitionName);
+    }
+    long long start = statsNow();
+    int result = formatPartition(partitionName);
+    recordCall(OP_FORMAT, start, result == -1, 0, 0, 0, 0, result, partitionName, NULL);
+    return result;
+}
+
+/**
+ * @brief Ouvre un fichier.
+ * 
+ * @param fileName Le nom du fichier à ouvrir.
+ * @return Un pointeur vers la structure de fichier ou NULL en cas d'échec.
+ */
+file* myOpen(char* fileName) {
+    if (!INSTRUMENTED()) {
+        return openFile(fileName);
+    }
+    long long start = statsNow();
+    file* result = openFile(fileName);
+    recordCall(OP_OPEN, start, result == NULL, 0, result ? result->trace_id : 0, 0, 0,
+               result ? result->size : -1, fileName, NULL);
+    return result;
+}
+
+/**
+ * @brief Écrit dans un fichier.
+ * 
+ * @param f Le pointeur vers la structure de fichier.
+ * @param buffer Le tampon contenant les données à écrire.
+ * @param nBytes Le nombre d'octets à écrire.
+ * @return Le nombre d'octets écrits ou -1 en cas d'erreur.
+ */
+int myWrite(file* f, void* buffer, int nBytes) {
+    if (!INSTRUMENTED()) {
+        return writeFile(f, buffer, nBytes);
+    }
+    int position = f ? f->current_position : 0;
+    long long start = statsNow();
+    int result = writeFile(f, buffer, nBytes);
+    recordCall(OP_WRITE, start, result == -1, result > 0 ? result : 0, f ? f->trace_id : 0,
+               position, nBytes, result, NULL, NULL);
+    return result;
+}
+
+/**
+ * @brief Lit depuis un fichier.
+ * 
+ * @param f Le pointeur vers la structure de fichier.
+ * @param buffer Le tampon où stocker les données lues.
+ * @param nBytes Le nombre d'octets à lire.
+ * @return Le nombre d'octets lus ou -1 en cas d'erreur.
+ */
+int myRead(file* f, void* buffer, int nBytes) {
+    if (!INSTRUMENTED()) {
+        return readFile(f, buffer, nBytes);
+    }
+    int position = f ? f->current_position : 0;
+    long long start = statsNow();
+    int result = readFile(f, buffer, nBytes);
+    recordCall(OP_READ, start, result == -1, result > 0 ? result : 0, f ? f->trace_id : 0,
+               position, nBytes, result, NULL, NULL);
+    return result;
+}
+
+/**
+ * @brief Déplace le curseur de lecture/écriture dans le fichier.
+ * 
+ * @param f Le pointeur vers la structure de fichier.
+ * @param offset Le décalage par rapport à la position de base.
+ * @param base La position de base à partir de laquelle effectuer le décalage.
+ */
+void mySeek(file* f, int offset, int base) {
+    if (!INSTRUMENTED()) {
+        seekFile(f, offset, base);
+        return;
+    }
+    long long start = statsNow();
+    seekFile(f, offset, base);
+    recordCall(OP_SEEK, start, f == NULL, 0, f ? f->trace_id : 0, offset, base,
+               f ? f->current_position : -1, NULL, NULL);
+}
+
+/**
+ * @brief Supprime un fichier.
+ * 
+ * @param f Le pointeur vers la structure de fichier à supprimer.
+ */
+void myDelete(file* f) {
+    if (!INSTRUMENTED()) {
+        deleteFile(f);
+        return;
+    }
+    long long start = statsNow();
+    int handle = f ? f->trace_id : 0;
+    deleteFile(f);
+    recordCall(OP_DELETE, start, handle == 0, 0, handle, 0, 0, 0, NULL, NULL);
+}
+
+/**
+ * @brief Ferme un fichier sans le supprimer.
+ * 
+ * @param f Le pointeur vers la structure de fichier à libérer.
+ */
+void myClose(file* f) {
+    if (!INSTRUMENTED()) {
+        closeFile(f);
+        return;
+    }
+    long long start = statsNow();
+    int handle = f ? f->trace_id : 0;
+    closeFile(f);
+    recordCall(OP_CLOSE, start, handle == 0, 0, handle, 0, 0, 0, NULL, NULL);
+}
+
+/**
+ * @brief Copie un fichier source dans un fichier destination.
+ * 
+ * @param sourceName Le nom du fichier source.
+ * @param destName Le nom du fichier destination.
+ * @return 0 en cas de succès, -1 en cas d'échec.
+ */
+int myCopy(const char* sourceName, const char* destName) {
+    if (!INSTRUMENTED()) {
+        return copyFile(sourceName, destName, NULL);
+    }
+    long long start = statsNow();
+    long long copied = 0;
+    int result = copyFile(sourceName, destName, &copied);
+    recordCall(OP_COPY, start, result == -1, copied, 0, 0, 0, result, sourceName, destName);
+    return result;
+}
+
+/**
+ * @brief Renomme un fichier.
+ * 
+ * @param oldName Le nom du fichier à renommer.
+ * @param newName Le nouveau nom du fichier.
+ * @return 0 en cas de succès, -1 en cas d'échec.
+ */
+int myRename(const char* oldName, const char* newName) {
+    if (!INSTRUMENTED()) {
+        return renameFile(oldName, newName);
+    }
+    long long start = statsNow();
+    int result = renameFile(oldName, newName);
+    recordCall(OP_RENAME, start, result == -1, 0, 0, 0, 0, result, oldName, newName);
+    return result;
+}
+
+/**
+ * @brief Déplace un fichier.
+ * 
+ * @param sourceName Le nom du fichier source.
+ * @param destName Le nom du fichier destination.
+ * @return 0 en cas de succès, -1 en cas d'échec.
+ */
+int myMove(const char* sourceName, const char* destName) {
+    if (!INSTRUMENTED()) {
+        return moveFile(sourceName, destName);
+    }
+    long long start = statsNow();
+    int result = moveFile(sourceName, destName);
+    recordCall(OP_MOVE, start, result == -1, 0, 0, 0, 0, result, sourceName, destName);
+    return result;
+}
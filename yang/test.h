@@ -7,26 +7,82 @@
 #ifndef TEST_H
 #define TEST_H
 
+#include <stdint.h>
 #include <stdio.h>
 
 #define PARTITION_SIZE 1024 * 1024  /**< Taille de la partition 1 Mo */
 #define MAX_LENGTH 1024
 #define MAX_PARAMS 20
-#define BLOCK_SIZE 512 /**< Taille de chaque bloc de disque */
+#ifndef BLOCK_SIZE
+#define BLOCK_SIZE 512 /**< Taille de chaque bloc de disque (redéfinissable à la compilation) */
+#endif
 #define TOTAL_BLOCKS (PARTITION_SIZE / BLOCK_SIZE) /**< Nombre total de blocs */
+#define INLINE_DATA_SIZE 64 /**< Taille maximale des données stockées dans l'inode */
+#define TAIL_MAX_SIZE (BLOCK_SIZE / 2) /**< Taille maximale d'une queue regroupée dans un bloc partagé */
+#define COMPRESS_CHUNK_SIZE (8 * BLOCK_SIZE) /**< Taille logique d'un morceau de fichier compressé */
+#define RUN_HISTOGRAM_BUCKETS 32 /**< Classes de l'histogramme des zones libres (puissances de 2) */
+#define VIS_COLUMNS 64 /**< Largeur de la visualisation de la partition */
+#define VIS_CELLS (TOTAL_BLOCKS < 1024 ? TOTAL_BLOCKS : 1024) /**< Nombre de cases de la visualisation */
+#define VIS_CELL_BLOCKS ((TOTAL_BLOCKS + VIS_CELLS - 1) / VIS_CELLS) /**< Blocs résumés par case */
 
 /**
  * @brief Structure représentant le statut de la partition.
  */
 typedef struct {
-    char block_usage[TOTAL_BLOCKS]; /**< '0' pour libre, '1' pour utilisé */
+    char block_usage[TOTAL_BLOCKS]; /**< '0' pour libre, '1' pour utilisé, 'q' pour bloc de queues partagé */
+    int block_refs[TOTAL_BLOCKS]; /**< Nombre de fichiers référençant chaque bloc de données */
+    short tail_used[TOTAL_BLOCKS]; /**< Octets occupés dans chaque bloc de queues */
+    short tail_refs[TOTAL_BLOCKS]; /**< Nombre de queues vivantes dans chaque bloc de queues */
+    int tail_cursor; /**< Dernier bloc de queues ouvert, -1 si aucun */
+    int free_blocks; /**< Nombre de blocs libres */
+    int free_runs; /**< Nombre de zones libres (suites maximales de blocs libres) */
+    int largest_free_run; /**< Longueur de la plus grande zone libre */
+    int run_length[TOTAL_BLOCKS]; /**< Longueur de chaque zone libre, notée à ses deux extrémités */
+    int runs_by_length[TOTAL_BLOCKS + 1]; /**< Nombre de zones libres de chaque longueur */
+    int run_histogram[RUN_HISTOGRAM_BUCKETS]; /**< Zones libres de longueur [2^i, 2^(i+1)[ */
+    short cell_used[VIS_CELLS]; /**< Blocs utilisés dans chaque case de la visualisation */
+    short cell_tails[VIS_CELLS]; /**< Blocs de queues dans chaque case de la visualisation */
 } PartitionStatus;
 
+/**
+ * @brief Résumé de l'espace libre de la partition.
+ */
+typedef struct {
+    int total_blocks; /**< Nombre total de blocs */
+    int free_blocks; /**< Nombre de blocs libres */
+    int free_runs; /**< Nombre de zones libres */
+    int largest_free_run; /**< Longueur de la plus grande zone libre */
+    int run_histogram[RUN_HISTOGRAM_BUCKETS]; /**< Zones libres de longueur [2^i, 2^(i+1)[ */
+    double fragmentation; /**< 1 - plus grande zone / blocs libres (0 : aucun morcellement) */
+} SpaceReport;
+
 /**
  * @brief Variable globale représentant le statut de la partition.
  */
 extern PartitionStatus g_partitionStatus;
 
+/**
+ * @brief Entrée de la table des morceaux d'un fichier compressé.
+ */
+typedef struct {
+    uint32_t offset; /**< Position du morceau dans le fichier hôte, 0 s'il n'a jamais été écrit */
+    uint32_t length; /**< Taille stockée ; bit de poids fort à 1 si stocké sans compression */
+} ChunkEntry;
+
+/**
+ * @brief État en mémoire d'un fichier compressé par morceaux.
+ */
+typedef struct {
+    ChunkEntry* chunks; /**< Table des morceaux */
+    int chunks_count; /**< Nombre de morceaux */
+    int file_end; /**< Fin physique du fichier hôte (après la table) */
+    int live_bytes; /**< Octets des versions courantes des morceaux */
+    int dead_bytes; /**< Octets occupés par d'anciennes versions */
+    int accounted; /**< Taille physique réservée sur la partition */
+    char* cache; /**< Dernier morceau décompressé */
+    int cached_chunk; /**< Index du morceau en cache, -1 si aucun */
+} CompressionState;
+
 /**
  * @brief Structure représentant un fichier.
  */
@@ -37,6 +93,13 @@ typedef struct {
     char* data; /**< Données du fichier */
     int block_start; /**< Index du bloc de départ */
     int blocks_count; /**< Nombre de blocs utilisés */
+    int* block_map; /**< Bloc de la partition pour chaque bloc plein du fichier */
+    int tail_block; /**< Bloc de queues contenant la fin du fichier, -1 si aucun */
+    int tail_offset; /**< Décalage de la queue dans son bloc */
+    int tail_size; /**< Taille de la queue en octets */
+    int inline_data; /**< 1 si les données tiennent dans l'inode : aucun bloc de la partition */
+    CompressionState* compression; /**< État de compression, NULL pour un fichier ordinaire */
+    int trace_id; /**< Identifiant du fichier dans les traces d'appels */
 } file;
 
 /**
@@ -57,15 +120,39 @@ PartitionStatus* initializePartitionStatus(void);
 
 /**
  * @brief Visualise le statut des blocs de la partition.
+ *
+ * Chaque caractère résume VIS_CELL_BLOCKS blocs ('.' libres, '*' utilisés,
+ * '+' blocs de queues, ':' mélange) ; le tout est suivi du résumé de
+ * l'espace libre et écrit en un seul appel système.
  * @param status Pointeur vers la structure PartitionStatus à visualiser.
  */
 void visualizePartitionStatus(PartitionStatus* status);
 
+/**
+ * @brief Obtient le résumé de l'espace libre en temps constant.
+ *
+ * Les compteurs sont tenus à jour à chaque allocation et libération.
+ * @param report Structure à remplir.
+ */
+void getSpaceReport(SpaceReport* report);
+
+/**
+ * @brief Trouve des blocs libres consécutifs (premier trouvé).
+ * @param blocksNeeded Nombre de blocs consécutifs nécessaires.
+ * @return Index du premier bloc de la zone, -1 s'il n'y en a pas.
+ */
+int findFreeBlocks(int blocksNeeded);
+
 /**
  * @brief Alloue des blocs de disque pour un fichier.
+ *
+ * Les fichiers d'au plus INLINE_DATA_SIZE octets restent dans l'inode et
+ * n'utilisent aucun bloc. Au-delà, les blocs pleins sont alloués de façon
+ * contiguë et la fin du fichier (si elle fait au plus TAIL_MAX_SIZE octets)
+ * est regroupée avec celles d'autres fichiers dans un bloc de queues partagé.
  * @param f Pointeur vers la structure de fichier.
  * @param size Taille des données à allouer.
- * @return Nombre de blocs alloués avec succès, -1 en cas d'échec.
+ * @return Nombre de blocs pleins alloués avec succès, -1 en cas d'échec.
  */
 int allocateBlocks(file* f, int size);
 
@@ -75,13 +162,54 @@ int allocateBlocks(file* f, int size);
  */
 void freeBlocks(file* f);
 
+/**
+ * @brief Active ou désactive la déduplication des blocs écrits par myWrite.
+ *
+ * Quand elle est active, chaque bloc plein réécrit est identifié par une
+ * empreinte de son contenu ; un bloc identique déjà présent est partagé
+ * (avec compteur de références) au lieu d'occuper un nouveau bloc.
+ *
+ * Le gain porte sur l'espace de la partition, pas sur les entrées/sorties :
+ * les données d'un fichier restent dans son fichier hôte, où myWrite écrit
+ * tous les octets, partagés ou non. L'empreinte et la comparaison rendent
+ * même l'écriture un peu plus lente.
+ * @param enabled 1 pour activer, 0 pour désactiver.
+ */
+void setDeduplication(int enabled);
+
+/**
+ * @brief Calcule le taux de déduplication de la partition.
+ * @return Blocs référencés par les fichiers divisés par blocs occupés.
+ */
+double getDedupRatio(void);
+
+/**
+ * @brief Active ou désactive la compression des fichiers créés par myOpen.
+ *
+ * Un fichier compressé est découpé en morceaux de COMPRESS_CHUNK_SIZE octets
+ * compressés séparément ; une table des morceaux permet à myRead et mySeek
+ * d'accéder à n'importe quelle position en ne décompressant que les
+ * morceaux touchés. Les fichiers compressés existants sont reconnus à
+ * l'ouverture quel que soit ce réglage.
+ * @param enabled 1 pour activer, 0 pour désactiver.
+ */
+void setCompression(int enabled);
+
 /**
  * @brief Formatte une partition.
+ *
+ * L'image est créée creuse ; les blocs libérés par la suite sont rendus au
+ * système hôte (fallocate(FALLOC_FL_PUNCH_HOLE)) par lots, en arrière-plan.
  * @param partitionName Nom de la partition à formater.
  * @return 0 en cas de succès, -1 en cas d'échec.
  */
 int myFormat(char* partitionName);
 
+/**
+ * @brief Rend immédiatement à l'image les blocs libérés encore en attente.
+ */
+void flushDiscards(void);
+
 /**
  * @brief Ouvre un fichier.
  * @param fileName Nom du fichier à ouvrir.
@@ -109,6 +237,9 @@ int myRead(file* f, void* buffer, int nBytes);
 
 /**
  * @brief Déplace le curseur de lecture/écriture dans un fichier.
+ *
+ * La position peut dépasser la fin du fichier : l'écriture suivante laisse
+ * alors un trou qui se lit comme des zéros et n'occupe aucun bloc.
  * @param f Pointeur vers la structure de fichier.
  * @param offset Décalage à appliquer.
  * @param base Position de référence (SEEK_SET, SEEK_CUR, SEEK_END).
@@ -157,6 +288,12 @@ int myMove(const char* sourceName, const char* destName);
  */
 void myDelete(file* f);
 
+/**
+ * @brief Ferme un fichier : libère sa structure sans supprimer le fichier.
+ * @param f Pointeur vers la structure de fichier.
+ */
+void myClose(file* f);
+
 /**
  * @brief Copie un fichier.
  * @param sourceName Nom du fichier source.
@@ -0,0 +1,575 @@
+/**
+ * @file tests.c
+ * @brief Tests de non-régression du système de fichiers (cible make check).
+ *
+ * Chaque test s'exécute sur une partition fraîchement formatée dans un
+ * répertoire temporaire. Les messages de la bibliothèque sont envoyés vers
+ * /dev/null ; seuls les échecs sont écrits sur la sortie d'erreur.
+ */
+
+#include "test.h"
+#include "stats.h"
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#define TEST_IMAGE "tests.img" /**< Partition des tests */
+
+static int g_failures = 0; /**< Nombre de vérifications en échec */
+
+/**
+ * @brief Vérifie une condition et signale l'échec sans arrêter les tests.
+ */
+#define CHECK(condition, message)                                                  \
+    do {                                                                           \
+        if (!(condition)) {                                                        \
+            fprintf(stderr, "ÉCHEC %s:%d : %s\n", __FILE__, __LINE__, message);    \
+            ++g_failures;                                                          \
+        }                                                                          \
+    } while (0)
+
+/**
+ * @brief Crée un fichier vide et l'ouvre.
+ */
+static file* createFile(const char* name) {
+    FILE* fp = fopen(name, "wb");
+    if (!fp) {
+        perror("Échec de la création d'un fichier de test");
+        exit(1);
+    }
+    fclose(fp);
+    return myOpen((char*)name);
+}
+
+/**
+ * @brief Nombre de blocs libres de la partition.
+ */
+static int freeBlockCount(void) {
+    SpaceReport report;
+    getSpaceReport(&report);
+    return report.free_blocks;
+}
+
+/**
+ * @brief Ouvrir, écrire, fermer, rouvrir puis supprimer rend tous les blocs.
+ */
+static void testCloseKeepsBlocks(void) {
+    char buffer[3 * BLOCK_SIZE + 100];
+    memset(buffer, 'a', sizeof(buffer));
+    myFormat(TEST_IMAGE);
+    int start = freeBlockCount();
+
+    file* f = createFile("close.dat");
+    CHECK(myWrite(f, buffer, sizeof(buffer)) == (int)sizeof(buffer), "écriture");
+    int written = freeBlockCount();
+    CHECK(written < start, "l'écriture réserve des blocs");
+    myClose(f);
+    CHECK(freeBlockCount() == written, "la fermeture garde les blocs du fichier");
+
+    f = myOpen("close.dat");
+    CHECK(f != NULL, "réouverture");
+    CHECK(freeBlockCount() == written, "la réouverture reprend les blocs sans en réserver");
+    myDelete(f);
+    CHECK(freeBlockCount() == start, "la suppression après réouverture rend tous les blocs");
+}
+
+/**
+ * @brief Deux descripteurs fermés du même fichier ne gardent qu'une allocation.
+ */
+static void testCloseTwice(void) {
+    char buffer[2 * BLOCK_SIZE];
+    memset(buffer, 'b', sizeof(buffer));
+    myFormat(TEST_IMAGE);
+    int start = freeBlockCount();
+
+    file* f = createFile("twice.dat");
+    myWrite(f, buffer, sizeof(buffer));
+    myClose(f);
+    file* a = myOpen("twice.dat");
+    file* b = myOpen("twice.dat");
+    myClose(a);
+    myClose(b);
+    f = myOpen("twice.dat");
+    myDelete(f);
+    CHECK(freeBlockCount() == start, "fermer deux descripteurs du même fichier ne perd pas de blocs");
+}
+
+/**
+ * @brief Un fichier renommé emporte ses blocs gardés.
+ */
+static void testRenameClosed(void) {
+    char buffer[2 * BLOCK_SIZE];
+    memset(buffer, 'c', sizeof(buffer));
+    myFormat(TEST_IMAGE);
+    int start = freeBlockCount();
+
+    file* f = createFile("old.dat");
+    myWrite(f, buffer, sizeof(buffer));
+    myClose(f);
+    CHECK(myRename("old.dat", "new.dat") == 0, "renommage");
+    f = myOpen("new.dat");
+    myDelete(f);
+    CHECK(freeBlockCount() == start, "la suppression après renommage rend tous les blocs");
+}
+
+/**
+ * @brief Écrit un fichier sur l'hôte, hors de la bibliothèque.
+ */
+static void writeHostFile(const char* name, const void* data, size_t length) {
+    FILE* fp = fopen(name, "wb");
+    if (!fp || fwrite(data, 1, length, fp) < length) {
+        perror("Échec de l'écriture d'un fichier de test");
+        exit(1);
+    }
+    fclose(fp);
+}
+
+/**
+ * @brief Un fichier ordinaire qui commence par la signature n'est pas pris pour un fichier compressé.
+ */
+static void testPlainFileWithMagic(void) {
+    char content[200];
+    memset(content, 'd', sizeof(content));
+    memcpy(content, "MYLZ", 4);
+    myFormat(TEST_IMAGE);
+    writeHostFile("magic.dat", content, sizeof(content));
+
+    char buffer[sizeof(content)];
+    file* f = myOpen("magic.dat");
+    CHECK(f != NULL, "ouverture d'un fichier ordinaire commençant par MYLZ");
+    if (f) {
+        CHECK(getFileSize(f) == (int)sizeof(content), "taille physique conservée");
+        CHECK(myRead(f, buffer, sizeof(buffer)) == (int)sizeof(buffer) &&
+              memcmp(buffer, content, sizeof(content)) == 0, "contenu lu tel quel");
+        myDelete(f);
+    }
+}
+
+/**
+ * @brief Un fichier compressé rouvert, même après reformatage, est relu ; un en-tête corrompu est refusé.
+ */
+static void testCompressedHeader(void) {
+    char content[3 * BLOCK_SIZE];
+    for (int i = 0; i < (int)sizeof(content); ++i) {
+        content[i] = (char)('a' + i % 7);
+    }
+    myFormat(TEST_IMAGE);
+    setCompression(1);
+    file* f = createFile("packed.dat");
+    setCompression(0);
+    CHECK(myWrite(f, content, sizeof(content)) == (int)sizeof(content), "écriture compressée");
+    myClose(f);
+
+    char buffer[sizeof(content)];
+    f = myOpen("packed.dat");
+    CHECK(f != NULL && myRead(f, buffer, sizeof(buffer)) == (int)sizeof(buffer) &&
+          memcmp(buffer, content, sizeof(content)) == 0, "relecture après réouverture");
+    myClose(f);
+
+    // La table des fichiers compressés est perdue : l'en-tête suffit à reconnaître le fichier
+    myFormat(TEST_IMAGE);
+    f = myOpen("packed.dat");
+    CHECK(f != NULL && getFileSize(f) == (int)sizeof(content) &&
+          myRead(f, buffer, sizeof(buffer)) == (int)sizeof(buffer) &&
+          memcmp(buffer, content, sizeof(content)) == 0, "relecture après reformatage");
+    myClose(f);
+
+    // Nombre de morceaux démesuré : le calcul de la table déborderait
+    FILE* fp = fopen("packed.dat", "rb+");
+    uint32_t chunks = 0xffffffffu;
+    fseek(fp, 12, SEEK_SET);
+    fwrite(&chunks, sizeof(chunks), 1, fp);
+    fclose(fp);
+    f = myOpen("packed.dat");
+    CHECK(f == NULL, "en-tête corrompu refusé");
+    remove("packed.dat");
+}
+
+/**
+ * @brief Un fichier compressé récrit plusieurs fois est récompacté sans perdre son contenu.
+ *
+ * Le contenu est limité au huitième de la partition pour que plusieurs
+ * versions y tiennent quelle que soit la taille des blocs.
+ */
+static void testCompressedCompaction(void) {
+    char content[8 * BLOCK_SIZE < PARTITION_SIZE / 8 ? 8 * BLOCK_SIZE : PARTITION_SIZE / 8];
+    myFormat(TEST_IMAGE);
+    int start = freeBlockCount();
+    setCompression(1);
+    file* f = createFile("rewritten.dat");
+    setCompression(0);
+    srand(7);
+    for (int pass = 0; pass < 6; ++pass) {
+        for (int i = 0; i < (int)sizeof(content); ++i) {
+            content[i] = (char)rand();  // Incompressible : chaque version occupe un morceau entier
+        }
+        mySeek(f, 0, SEEK_SET);
+        CHECK(myWrite(f, content, sizeof(content)) == (int)sizeof(content), "récriture compressée");
+    }
+    myClose(f);
+    CHECK(access("rewritten.dat.compact", F_OK) != 0, "pas de fichier temporaire laissé");
+
+    struct stat st;
+    CHECK(stat("rewritten.dat", &st) == 0 && st.st_size < 3 * (off_t)sizeof(content),
+          "les anciennes versions ont été éliminées");
+    CHECK(start - freeBlockCount() <= (st.st_size + BLOCK_SIZE - 1) / BLOCK_SIZE + 1,
+          "les blocs des anciennes versions sont rendus");
+    char buffer[sizeof(content)];
+    f = myOpen("rewritten.dat");
+    CHECK(f != NULL && myRead(f, buffer, sizeof(buffer)) == (int)sizeof(buffer) &&
+          memcmp(buffer, content, sizeof(content)) == 0, "relecture après récompactage");
+    myDelete(f);
+}
+
+/**
+ * @brief Seuls les blocs de contenu identique sont partagés.
+ */
+static void testDedupSharesIdenticalBlocks(void) {
+    char content[4 * BLOCK_SIZE];
+    for (int i = 0; i < (int)sizeof(content); ++i) {
+        content[i] = (char)(i / BLOCK_SIZE + i % 13);  // Quatre blocs différents
+    }
+    myFormat(TEST_IMAGE);
+    setDeduplication(1);
+    int start = freeBlockCount();
+    file* a = createFile("dedup_a.dat");
+    file* b = createFile("dedup_b.dat");
+    myWrite(a, content, sizeof(content));
+    myWrite(b, content, sizeof(content));
+    CHECK(start - freeBlockCount() == 4, "deux copies identiques occupent quatre blocs");
+
+    content[5] ^= 1;  // Le premier bloc de c diffère d'un octet
+    file* c = createFile("dedup_c.dat");
+    myWrite(c, content, sizeof(content));
+    CHECK(start - freeBlockCount() == 5, "un bloc différent d'un octet n'est pas partagé");
+
+    char buffer[sizeof(content)];
+    mySeek(a, 0, SEEK_SET);
+    CHECK(myRead(a, buffer, sizeof(buffer)) == (int)sizeof(buffer) && buffer[5] != content[5],
+          "le fichier d'origine garde son contenu");
+    myDelete(a);
+    myDelete(b);
+    myDelete(c);
+    setDeduplication(0);
+    CHECK(freeBlockCount() == start, "la suppression des copies rend tous les blocs");
+}
+
+/**
+ * @brief Une copie occupe ses propres blocs, partagés avec la source si la déduplication est active.
+ */
+static void testCopyAccountsBlocks(void) {
+    char content[4 * BLOCK_SIZE];
+    for (int i = 0; i < (int)sizeof(content); ++i) {
+        content[i] = (char)(i / BLOCK_SIZE + i % 11);
+    }
+    myFormat(TEST_IMAGE);
+    int start = freeBlockCount();
+    file* f = createFile("copy_src.dat");
+    myWrite(f, content, sizeof(content));
+    myClose(f);
+
+    CHECK(myCopy("copy_src.dat", "copy_plain.dat") == 0, "copie sans déduplication");
+    CHECK(start - freeBlockCount() == 8, "la copie réserve ses propres blocs");
+    f = myOpen("copy_plain.dat");
+    myDelete(f);
+    CHECK(start - freeBlockCount() == 4, "la suppression de la copie rend ses blocs");
+
+    // Indexer la source, puis la copier : seuls les blocs modifiés entre-temps sont nouveaux
+    setDeduplication(1);
+    f = myOpen("copy_src.dat");
+    myWrite(f, content, sizeof(content));
+    myClose(f);
+    CHECK(myCopy("copy_src.dat", "copy_dedup.dat") == 0, "copie avec déduplication");
+    CHECK(start - freeBlockCount() == 4, "une copie identique partage tous ses blocs");
+    f = myOpen("copy_dedup.dat");
+    content[BLOCK_SIZE] ^= 1;
+    myWrite(f, content, sizeof(content));
+    CHECK(start - freeBlockCount() == 5, "un bloc modifié dans la copie n'est plus partagé");
+    myDelete(f);
+    setDeduplication(0);
+    f = myOpen("copy_src.dat");
+    myDelete(f);
+    CHECK(freeBlockCount() == start, "la suppression de la source et de la copie rend tous les blocs");
+}
+
+/**
+ * @brief Une écriture après la fin laisse un trou lu comme des zéros ; les blocs rendus sont libérés dans l'image.
+ */
+static void testHoleAndDiscard(void) {
+    int holeSize = PARTITION_SIZE / 8;
+    int dataSize = PARTITION_SIZE / 4;
+    char* image = (char*)malloc(PARTITION_SIZE);
+    char* data = (char*)malloc(dataSize);
+    char* buffer = (char*)malloc(holeSize + dataSize);
+    if (!image || !data || !buffer) {
+        perror("Échec de l'allocation des tampons de test");
+        exit(1);
+    }
+    myFormat(TEST_IMAGE);
+    int start = freeBlockCount();
+
+    // Remplir l'image pour que chaque libération y retire des blocs alloués
+    memset(image, 'i', PARTITION_SIZE);
+    writeHostFile(TEST_IMAGE, image, PARTITION_SIZE);
+    struct stat before;
+    CHECK(stat(TEST_IMAGE, &before) == 0, "image remplie");
+
+    memset(data, 'h', dataSize);
+    file* f = createFile("hole.dat");
+    mySeek(f, holeSize, SEEK_SET);
+    CHECK(myWrite(f, data, dataSize) == dataSize, "écriture après la fin du fichier");
+    CHECK(getFileSize(f) == holeSize + dataSize, "le trou compte dans la taille");
+    CHECK(start - freeBlockCount() == dataSize / BLOCK_SIZE, "le trou n'occupe aucun bloc");
+
+    memset(buffer, 'x', holeSize + dataSize);
+    mySeek(f, 0, SEEK_SET);
+    CHECK(myRead(f, buffer, holeSize + dataSize) == holeSize + dataSize, "relecture du fichier troué");
+    int zeros = 1;
+    for (int i = 0; i < holeSize; ++i) {
+        zeros &= buffer[i] == 0;
+    }
+    CHECK(zeros, "le trou est lu comme des zéros");
+    CHECK(memcmp(buffer + holeSize, data, dataSize) == 0, "les données après le trou sont relues");
+
+    myDelete(f);
+    CHECK(freeBlockCount() == start, "la suppression rend tous les blocs");
+    flushDiscards();
+    struct stat after;
+    CHECK(stat(TEST_IMAGE, &after) == 0 && after.st_blocks < before.st_blocks,
+          "les blocs rendus sont libérés dans l'image");
+    free(image);
+    free(data);
+    free(buffer);
+}
+
+#define CHURN_FILES 16 /**< Fichiers ouverts à la fois par le test de brassage */
+#define CHURN_OPS 2000 /**< Opérations du test de brassage */
+
+/**
+ * @brief Compare les statistiques des zones libres à un recomptage complet de la table d'occupation.
+ */
+static int freeRunsMatch(void) {
+    SpaceReport report;
+    getSpaceReport(&report);
+    int freeBlocks = 0;
+    int runs = 0;
+    int largest = 0;
+    int histogram[RUN_HISTOGRAM_BUCKETS] = { 0 };
+    for (int i = 0; i < TOTAL_BLOCKS; ) {
+        if (g_partitionStatus.block_usage[i] != '0') {
+            ++i;
+            continue;
+        }
+        int length = 0;
+        while (i + length < TOTAL_BLOCKS && g_partitionStatus.block_usage[i + length] == '0') {
+            ++length;
+        }
+        int bucket = 0;
+        while ((length >> (bucket + 1)) != 0) {
+            ++bucket;
+        }
+        freeBlocks += length;
+        ++runs;
+        largest = length > largest ? length : largest;
+        ++histogram[bucket];
+        i += length;
+    }
+    return report.free_blocks == freeBlocks && report.free_runs == runs &&
+           report.largest_free_run == largest &&
+           memcmp(report.run_histogram, histogram, sizeof(histogram)) == 0;
+}
+
+/**
+ * @brief Des allocations et libérations aléatoires gardent les statistiques des zones libres exactes.
+ */
+static void testFreeRunChurn(void) {
+    int maxSize = 8 * BLOCK_SIZE;
+    char* buffer = (char*)malloc(maxSize);
+    if (!buffer) {
+        perror("Échec de l'allocation du tampon de test");
+        exit(1);
+    }
+    myFormat(TEST_IMAGE);
+    file* files[CHURN_FILES] = { NULL };
+    srand(11);
+    int mismatches = 0;
+    for (int op = 0; op < CHURN_OPS; ++op) {
+        int slot = rand() % CHURN_FILES;
+        if (files[slot] && rand() % 3 == 0) {
+            myDelete(files[slot]);  // Libération
+            files[slot] = NULL;
+        } else {
+            if (!files[slot]) {
+                char name[32];
+                snprintf(name, sizeof(name), "churn%d.dat", slot);
+                files[slot] = createFile(name);
+            }
+            // Écriture à une position quelconque : agrandit, remplit un trou ou réécrit
+            int size = 1 + rand() % maxSize;
+            memset(buffer, 'a' + op % 26, size);
+            mySeek(files[slot], rand() % maxSize, SEEK_SET);
+            myWrite(files[slot], buffer, size);
+        }
+        mismatches += !freeRunsMatch();
+    }
+    CHECK(mismatches == 0, "les statistiques des zones libres suivent la table d'occupation");
+    for (int i = 0; i < CHURN_FILES; ++i) {
+        if (files[i]) {
+            myDelete(files[i]);
+        }
+    }
+    CHECK(freeRunsMatch() && freeBlockCount() == TOTAL_BLOCKS, "partition entièrement libre à la fin");
+    free(buffer);
+}
+
+/**
+ * @brief Après un changement de répertoire, les libérations visent toujours l'image formatée.
+ */
+static void testDiscardAfterCd(void) {
+    char buffer[8 * BLOCK_SIZE];
+    memset(buffer, 'e', sizeof(buffer));
+    myFormat(TEST_IMAGE);
+    file* f = createFile("discard.dat");
+    myWrite(f, buffer, sizeof(buffer));
+    myDelete(f);
+
+    // Un fichier homonyme de l'image dans le nouveau répertoire courant ne doit pas être touché
+    char* cd[] = { "cd", "sub", NULL };
+    char decoy[sizeof(buffer)];
+    memset(decoy, 'z', sizeof(decoy));
+    mkdir("sub", 0700);
+    CHECK(myCd(cd) == 0, "changement de répertoire");
+    writeHostFile(TEST_IMAGE, decoy, sizeof(decoy));
+    flushDiscards();
+
+    char check[sizeof(decoy)] = { 0 };
+    FILE* fp = fopen(TEST_IMAGE, "rb");
+    CHECK(fp && fread(check, 1, sizeof(check), fp) == sizeof(check) &&
+          memcmp(check, decoy, sizeof(decoy)) == 0, "le fichier homonyme garde son contenu");
+    if (fp) {
+        fclose(fp);
+    }
+    remove(TEST_IMAGE);
+    CHECK(chdir("..") == 0 && rmdir("sub") == 0, "retour au répertoire de test");
+}
+
+/**
+ * @brief Après resetStats, seuls les appels suivants sont comptés.
+ */
+static void testResetStats(void) {
+    char buffer[BLOCK_SIZE] = { 0 };
+    myFormat(TEST_IMAGE);
+    setStatsEnabled(1);
+    file* f = createFile("stats.dat");
+    myWrite(f, buffer, sizeof(buffer));
+    resetStats();
+
+    Stats stats;
+    myStats(&stats);
+    CHECK(stats.ops[OP_WRITE].calls == 0 && stats.ops[OP_WRITE].bytes == 0, "compteurs remis à zéro");
+    myWrite(f, buffer, sizeof(buffer));
+    myStats(&stats);
+    CHECK(stats.ops[OP_WRITE].calls == 1 && stats.ops[OP_WRITE].bytes == sizeof(buffer),
+          "seule l'écriture suivante est comptée");
+    myDelete(f);
+    setStatsEnabled(0);
+}
+
+/**
+ * @brief Un petit fichier relu par un second descripteur ou après réouverture donne son dernier contenu.
+ */
+static void testInlineTwoHandles(void) {
+    char buffer[8] = { 0 };
+    myFormat(TEST_IMAGE);
+    file* a = createFile("inline.dat");
+    myWrite(a, "hello", 5);
+    file* b = myOpen("inline.dat");
+    mySeek(a, 0, SEEK_SET);
+    myWrite(a, "HELLO", 5);
+    CHECK(myRead(b, buffer, 5) == 5 && memcmp(buffer, "HELLO", 5) == 0,
+          "le second descripteur lit l'écriture du premier");
+    myClose(b);
+    myClose(a);
+
+    memset(buffer, 0, sizeof(buffer));
+    a = myOpen("inline.dat");
+    CHECK(a != NULL && myRead(a, buffer, sizeof(buffer)) == 5 && memcmp(buffer, "HELLO", 5) == 0,
+          "relecture après réouverture");
+    myDelete(a);
+}
+
+/**
+ * @brief N petits fichiers occupent moins de N blocs (données dans l'inode ou queues regroupées).
+ */
+static void testSmallFilesShareBlocks(void) {
+    enum { FILES = 16 };
+    char content[TAIL_MAX_SIZE / 2];
+    memset(content, 's', sizeof(content));
+    myFormat(TEST_IMAGE);
+    int start = freeBlockCount();
+    file* files[FILES];
+    char name[32];
+    for (int i = 0; i < FILES; ++i) {
+        snprintf(name, sizeof(name), "tiny%d.dat", i);
+        files[i] = createFile(name);
+        myWrite(files[i], content, INLINE_DATA_SIZE);
+    }
+    CHECK(freeBlockCount() == start, "les fichiers de INLINE_DATA_SIZE octets n'occupent aucun bloc");
+
+    for (int i = 0; i < FILES; ++i) {
+        myWrite(files[i], content, sizeof(content));  // Au-delà de l'inode : une queue partagée
+    }
+    int used = start - freeBlockCount();
+    CHECK(used > 0 && used < FILES, "les queues de N petits fichiers occupent moins de N blocs");
+
+    char buffer[sizeof(content)];
+    mySeek(files[3], INLINE_DATA_SIZE, SEEK_SET);
+    CHECK(myRead(files[3], buffer, sizeof(buffer)) == (int)sizeof(buffer) &&
+          memcmp(buffer, content, sizeof(content)) == 0, "relecture d'une queue regroupée");
+    for (int i = 0; i < FILES; ++i) {
+        myDelete(files[i]);
+    }
+    CHECK(freeBlockCount() == start, "la suppression rend les blocs de queues");
+}
+
+int main(void) {
+    if (!freopen("/dev/null", "w", stdout)) {
+        perror("Échec de la préparation de la sortie");
+        return 1;
+    }
+    char dir[] = "/tmp/projet-os-tests-XXXXXX";
+    if (!mkdtemp(dir) || chdir(dir) != 0) {
+        perror("Échec de la création du répertoire de test");
+        return 1;
+    }
+
+    testCloseKeepsBlocks();
+    testCloseTwice();
+    testRenameClosed();
+    testPlainFileWithMagic();
+    testCompressedHeader();
+    testCompressedCompaction();
+    testDedupSharesIdenticalBlocks();
+    testCopyAccountsBlocks();
+    testHoleAndDiscard();
+    testFreeRunChurn();
+    testDiscardAfterCd();
+    testResetStats();
+    testInlineTwoHandles();
+    testSmallFilesShareBlocks();
+
+    flushDiscards();
+    remove(TEST_IMAGE);
+    if (chdir("/") != 0 || rmdir(dir) != 0) {
+        fprintf(stderr, "Répertoire de test non supprimé : %s\n", dir);
+    }
+    if (g_failures) {
+        fprintf(stderr, "%d vérification(s) en échec\n", g_failures);
+        return 1;
+    }
+    fprintf(stderr, "Tous les tests sont passés.\n");
+    return 0;
+}
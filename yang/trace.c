@@ -0,0 +1,147 @@
+/**
+ * @file trace.c
+ * @brief Implémentation de l'enregistrement et de la lecture des traces.
+ */
+
+#include "trace.h"
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define TRACE_BUFFER_SIZE (1 << 20) /**< Tampon d'écriture de la trace */
+
+int g_traceEnabled = 0;
+
+static FILE* g_traceFile = NULL; /**< Trace en cours d'écriture */
+static char* g_traceBuffer = NULL; /**< Tampon de g_traceFile */
+static long long g_traceStart = 0; /**< Début de la trace (statsNow) */
+static pthread_mutex_t g_traceLock = PTHREAD_MUTEX_INITIALIZER; /**< Sérialise les écritures */
+static uint32_t g_nextThread = 0; /**< Prochain numéro de fil */
+static __thread uint32_t t_thread = 0; /**< Numéro du fil courant, 0 si pas encore attribué */
+
+int startTrace(const char* path) {
+    if (g_traceFile) {
+        return -1;
+    }
+    FILE* fp = fopen(path, "wb");
+    if (!fp) {
+        perror("Échec de la création de la trace");
+        return -1;
+    }
+    g_traceBuffer = (char*)malloc(TRACE_BUFFER_SIZE);
+    if (g_traceBuffer) {
+        setvbuf(fp, g_traceBuffer, _IOFBF, TRACE_BUFFER_SIZE);
+    }
+
+    TraceHeader header = { TRACE_MAGIC, TRACE_VERSION };
+    if (fwrite(&header, sizeof(header), 1, fp) != 1) {
+        perror("Échec de l'écriture de la trace");
+        fclose(fp);
+        free(g_traceBuffer);
+        g_traceBuffer = NULL;
+        return -1;
+    }
+
+    g_traceStart = statsNow();
+    g_traceFile = fp;
+    g_traceEnabled = 1;
+    return 0;
+}
+
+void stopTrace(void) {
+    pthread_mutex_lock(&g_traceLock);
+    g_traceEnabled = 0;
+    if (g_traceFile) {
+        if (fclose(g_traceFile) != 0) {
+            perror("Échec de l'écriture de la trace");
+        }
+        g_traceFile = NULL;
+        free(g_traceBuffer);
+        g_traceBuffer = NULL;
+    }
+    pthread_mutex_unlock(&g_traceLock);
+}
+
+/**
+ * @brief Longueur enregistrée d'un nom (tronqué à TRACE_NAME_MAX).
+ */
+static uint16_t nameLength(const char* name) {
+    if (!name) {
+        return 0;
+    }
+    size_t len = strlen(name);
+    return (uint16_t)(len < TRACE_NAME_MAX ? len : TRACE_NAME_MAX);
+}
+
+void traceRecord(OpKind op, long long startNs, int failed, int handle, long long arg0,
+                 long long arg1, long long result, const char* name0, const char* name1) {
+    long long end = statsNow();
+    TraceRecord record;
+    memset(&record, 0, sizeof(record));
+    record.arg0 = arg0;
+    record.arg1 = arg1;
+    record.result = result;
+    record.duration_ns = (uint32_t)(end - startNs < UINT32_MAX ? end - startNs : UINT32_MAX);
+    record.handle = handle;
+    record.name_len[0] = nameLength(name0);
+    record.name_len[1] = nameLength(name1);
+    record.op = (uint8_t)op;
+    record.failed = failed != 0;
+
+    pthread_mutex_lock(&g_traceLock);
+    if (g_traceFile) {
+        if (t_thread == 0) {
+            t_thread = ++g_nextThread;
+        }
+        record.thread = t_thread;
+        record.time_ns = startNs > g_traceStart ? startNs - g_traceStart : 0;
+        fwrite(&record, sizeof(record), 1, g_traceFile);
+        if (record.name_len[0] > 0) {
+            fwrite(name0, 1, record.name_len[0], g_traceFile);
+        }
+        if (record.name_len[1] > 0) {
+            fwrite(name1, 1, record.name_len[1], g_traceFile);
+        }
+    }
+    pthread_mutex_unlock(&g_traceLock);
+}
+
+FILE* openTrace(const char* path) {
+    FILE* fp = fopen(path, "rb");
+    if (!fp) {
+        perror("Échec de l'ouverture de la trace");
+        return NULL;
+    }
+    TraceHeader header;
+    if (fread(&header, sizeof(header), 1, fp) != 1 ||
+        header.magic != TRACE_MAGIC || header.version != TRACE_VERSION) {
+        fprintf(stderr, "Trace invalide : %s\n", path);
+        fclose(fp);
+        return NULL;
+    }
+    return fp;
+}
+
+/**
+ * @brief Lit un nom de la trace et ajoute le zéro final.
+ */
+static int readName(FILE* fp, char* name, uint16_t len) {
+    if (len > TRACE_NAME_MAX || fread(name, 1, len, fp) != len) {
+        return -1;
+    }
+    name[len] = '\0';
+    return 0;
+}
+
+int readTraceRecord(FILE* fp, TraceRecord* record, char* name0, char* name1) {
+    size_t n = fread(record, 1, sizeof(*record), fp);
+    if (n == 0) {
+        return 0;
+    }
+    if (n != sizeof(*record) || record->op >= OP_COUNT ||
+        readName(fp, name0, record->name_len[0]) == -1 ||
+        readName(fp, name1, record->name_len[1]) == -1) {
+        return -1;
+    }
+    return 1;
+}
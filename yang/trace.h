@@ -0,0 +1,104 @@
+/**
+ * @file trace.h
+ * @brief Enregistrement binaire des appels à l'API et relecture des traces.
+ *
+ * Une trace commence par un en-tête (TraceHeader) suivi d'enregistrements
+ * (TraceRecord), chacun suivi de ses noms de fichiers sans zéro final. Les
+ * entiers sont écrits dans l'ordre de la machine ; les fichiers ouverts sont
+ * désignés par l'identifiant attribué par myOpen (champ trace_id).
+ */
+
+#ifndef TRACE_H
+#define TRACE_H
+
+#include "stats.h"
+#include <stdint.h>
+#include <stdio.h>
+
+#define TRACE_MAGIC 0x43525459 /**< "YTRC" */
+#define TRACE_VERSION 1 /**< Version du format */
+#define TRACE_NAME_MAX 1024 /**< Longueur maximale d'un nom relu */
+
+/**
+ * @brief En-tête d'une trace.
+ */
+typedef struct {
+    uint32_t magic; /**< TRACE_MAGIC */
+    uint32_t version; /**< TRACE_VERSION */
+} TraceHeader;
+
+/**
+ * @brief Un appel enregistré.
+ *
+ * Signification des arguments selon l'opération :
+ * - OP_WRITE, OP_READ : arg0 = position avant l'appel, arg1 = octets demandés ;
+ * - OP_SEEK : arg0 = décalage, arg1 = origine (SEEK_SET, SEEK_CUR, SEEK_END) ;
+ * - OP_OPEN : handle = identifiant attribué, name0 = nom du fichier ;
+ * - OP_DELETE, OP_CLOSE : handle = fichier supprimé ou fermé ;
+ * - OP_FORMAT : name0 = nom de la partition ;
+ * - OP_COPY, OP_RENAME, OP_MOVE : name0 = source, name1 = destination.
+ */
+typedef struct {
+    uint64_t time_ns; /**< Début de l'appel depuis le début de la trace */
+    int64_t arg0; /**< Premier argument */
+    int64_t arg1; /**< Second argument */
+    int64_t result; /**< Valeur de retour */
+    uint32_t duration_ns; /**< Durée de l'appel */
+    uint32_t thread; /**< Fil appelant (numéro attribué par la trace) */
+    int32_t handle; /**< Fichier concerné, 0 si aucun */
+    uint16_t name_len[2]; /**< Longueur des noms qui suivent l'enregistrement */
+    uint8_t op; /**< Opération (OpKind) */
+    uint8_t failed; /**< 1 si l'appel a échoué */
+    uint8_t reserved[6]; /**< Alignement, à zéro */
+} TraceRecord;
+
+/**
+ * @brief Enregistrement actif (1) ou non (0).
+ */
+extern int g_traceEnabled;
+
+/**
+ * @brief Commence l'enregistrement des appels dans un fichier.
+ * @param path Chemin de la trace (remplacée si elle existe).
+ * @return 0 en cas de succès, -1 en cas d'échec.
+ */
+int startTrace(const char* path);
+
+/**
+ * @brief Termine l'enregistrement et ferme la trace.
+ */
+void stopTrace(void);
+
+/**
+ * @brief Enregistre un appel terminé.
+ * @param op L'opération.
+ * @param startNs L'instant de début (statsNow).
+ * @param failed 1 si l'appel a échoué.
+ * @param handle Identifiant du fichier concerné, 0 si aucun.
+ * @param arg0 Premier argument (voir TraceRecord).
+ * @param arg1 Second argument (voir TraceRecord).
+ * @param result Valeur de retour.
+ * @param name0 Premier nom de fichier, ou NULL.
+ * @param name1 Second nom de fichier, ou NULL.
+ */
+void traceRecord(OpKind op, long long startNs, int failed, int handle, long long arg0,
+                 long long arg1, long long result, const char* name0, const char* name1);
+
+/**
+ * @brief Ouvre une trace en lecture et vérifie son en-tête.
+ * @param path Chemin de la trace.
+ * @return Le flux positionné sur le premier enregistrement, NULL en cas d'échec.
+ */
+FILE* openTrace(const char* path);
+
+/**
+ * @brief Lit l'enregistrement suivant d'une trace.
+ * @param fp Flux renvoyé par openTrace.
+ * @param record Enregistrement lu.
+ * @param name0 Reçoit le premier nom (TRACE_NAME_MAX + 1 octets).
+ * @param name1 Reçoit le second nom (TRACE_NAME_MAX + 1 octets).
+ * @return 1 si un enregistrement a été lu, 0 en fin de trace, -1 si la trace est invalide.
+ */
+int readTraceRecord(FILE* fp, TraceRecord* record, char* name0, char* name1);
+
+#endif // TRACE_H